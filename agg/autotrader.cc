@@ -33,38 +33,52 @@ constexpr int TICK_SIZE_IN_CENTS = 100;
 constexpr int MIN_BID_NEARST_TICK = (MINIMUM_BID + TICK_SIZE_IN_CENTS) / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
 constexpr int MAX_ASK_NEAREST_TICK = MAXIMUM_ASK / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
 
-#include <chrono>
-#include <cstdint>
-#include <iostream>
+// Convert with capture_convert to get market_data_etf.csv and
+// market_data_future.csv.
+constexpr const char* RECORD_FILENAME = "market_data.bin";
 
-uint64_t epoch_time() {
-  using namespace std::chrono;
-  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-}
+// Columnar captures for replay, e.g. market_data_future_book.col.
+constexpr const char* CAPTURE_PREFIX = "market_data";
 
-AutoTrader::AutoTrader(boost::asio::io_context& context) : BaseAutoTrader(context)
+AutoTrader::AutoTrader(boost::asio::io_context& context) : BaseAutoTrader(context),
+                                                           mRecorder(RECORD_FILENAME, CAPTURE_PREFIX),
+                                                           mEvents(EVENT_LOG_FILENAME)
 {
-	mOutFileETF.open("market_data_etf.csv");
-	mOutFileFuture.open("market_data_future.csv");
+	if (!mEvents.IsOpen())
+	{
+		RLOG(LG_AT, LogLevel::LL_WARNING) << "could not open " << EVENT_LOG_FILENAME
+		                                  << "; callbacks will not be recorded";
+	}
 }
 
 void AutoTrader::DisconnectHandler()
 {
-	mOutFileETF.close();
-	mOutFileFuture.close();
+	mEvents.RecordDisconnect();
+	mRecorder.Close();
+	mEvents.Close();
+	if (mRecorder.Dropped() != 0)
+	{
+		RLOG(LG_AT, LogLevel::LL_WARNING) << "recorder dropped " << mRecorder.Dropped()
+		                                  << " order books because the disk fell behind";
+	}
+	if (mEvents.Dropped() != 0)
+	{
+		RLOG(LG_AT, LogLevel::LL_WARNING) << "event recorder dropped " << mEvents.Dropped()
+		                                  << " events because the disk fell behind";
+	}
 }
 
 void AutoTrader::ErrorMessageHandler(unsigned long clientOrderId,
                                      const std::string& errorMessage)
 {
-
+	mEvents.RecordError(clientOrderId, errorMessage);
 }
 
 void AutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long price,
                                            unsigned long volume)
 {
-	
+	mEvents.RecordHedgeFilled(clientOrderId, price, volume);
 }
 
 void AutoTrader::OrderBookMessageHandler(Instrument instrument,
@@ -74,25 +88,16 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
 {
-	
-	auto& fileOut = instrument == Instrument::FUTURE ? mOutFileFuture : mOutFileETF;
-
-	fileOut << epoch_time();
-	for(int i = 0; i < TOP_LEVEL_COUNT; i++) {
-		fileOut << "," << askPrices[i] << "," << askVolumes[i];
-	}
-	for(int i = 0; i < TOP_LEVEL_COUNT; i++) {
-		fileOut << "," << bidPrices[i] << "," << bidVolumes[i];
-	}
-	fileOut << std::endl;
-
+	mEvents.RecordOrderBook(instrument, sequenceNumber, askPrices, askVolumes, bidPrices, bidVolumes);
+	mRecorder.Record(instrument, RecordType::ORDER_BOOK, sequenceNumber,
+	                 askPrices, askVolumes, bidPrices, bidVolumes);
 }
 
 void AutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long price,
                                            unsigned long volume)
 {
-
+	mEvents.RecordOrderFilled(clientOrderId, price, volume);
 }
 
 void AutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
@@ -100,7 +105,7 @@ void AutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
                                            unsigned long remainingVolume,
                                            signed long fees)
 {
-
+	mEvents.RecordOrderStatus(clientOrderId, fillVolume, remainingVolume, fees);
 }
 
 void AutoTrader::TradeTicksMessageHandler(Instrument instrument,
@@ -110,5 +115,7 @@ void AutoTrader::TradeTicksMessageHandler(Instrument instrument,
                                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
                                           const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
 {
-
+	mEvents.RecordTradeTicks(instrument, sequenceNumber, askPrices, askVolumes, bidPrices, bidVolumes);
+	mRecorder.Record(instrument, RecordType::TRADE_TICKS, sequenceNumber,
+	                 askPrices, askVolumes, bidPrices, bidVolumes);
 }
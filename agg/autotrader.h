@@ -22,14 +22,15 @@
 #include <memory>
 #include <string>
 #include <unordered_set>
-#include <iostream>
-#include <fstream>
 
 #include <boost/asio/io_context.hpp>
 
 #include <ready_trader_go/baseautotrader.h>
 #include <ready_trader_go/types.h>
 
+#include "eventrecorder.h"
+#include "recorder.h"
+
 struct Order {
 	
 	unsigned long price;
@@ -105,8 +106,8 @@ public:
                                   const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes) override;
 
 private:
-	std::ofstream mOutFileETF;
-	std::ofstream mOutFileFuture;
+	Recorder mRecorder;
+	EventRecorder mEvents;
 };
 
 #endif //CPPREADY_TRADER_GO_AUTOTRADER_H
@@ -0,0 +1,108 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Turns a binary capture written by the Recorder into the CSV layout the
+// agg bot used to write directly: one file per instrument, one line per order
+// book of "epoch_ms,ask_price,ask_volume,...,bid_price,bid_volume,...".
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "recorder.h"
+
+using namespace ReadyTraderGo;
+
+constexpr std::size_t BATCH_SIZE = 4096;
+
+static void WriteBook(std::FILE* out, const MarketRecord& record)
+{
+    std::fprintf(out, "%llu", static_cast<unsigned long long>(record.timestamp / 1000000));
+    for (int i = 0; i < TOP_LEVEL_COUNT; i++)
+    {
+        std::fprintf(out, ",%lu,%lu", record.askPrices[i], record.askVolumes[i]);
+    }
+    for (int i = 0; i < TOP_LEVEL_COUNT; i++)
+    {
+        std::fprintf(out, ",%lu,%lu", record.bidPrices[i], record.bidVolumes[i]);
+    }
+    std::fputc('\n', out);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2 && argc != 4)
+    {
+        std::cerr << "usage: " << argv[0] << " CAPTURE [ETF_CSV FUTURE_CSV]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const char* etfFilename = argc == 4 ? argv[2] : "market_data_etf.csv";
+    const char* futureFilename = argc == 4 ? argv[3] : "market_data_future.csv";
+
+    std::FILE* in = std::fopen(argv[1], "rb");
+    if (in == nullptr)
+    {
+        std::cerr << "could not open " << argv[1] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    RecordFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, in) != 1
+        || std::memcmp(header.magic, RECORD_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != RECORD_FILE_VERSION
+        || header.recordSize != sizeof(MarketRecord))
+    {
+        std::cerr << argv[1] << " is not a capture file this tool understands" << std::endl;
+        std::fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    std::FILE* etf = std::fopen(etfFilename, "w");
+    std::FILE* future = std::fopen(futureFilename, "w");
+    if (etf == nullptr || future == nullptr)
+    {
+        std::cerr << "could not open output files" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<MarketRecord> batch(BATCH_SIZE);
+    unsigned long converted = 0;
+    while (std::size_t count = std::fread(batch.data(), sizeof(MarketRecord), BATCH_SIZE, in))
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const MarketRecord& record = batch[i];
+            if (record.type != static_cast<std::uint8_t>(RecordType::ORDER_BOOK))
+            {
+                continue;
+            }
+            bool isFuture = record.instrument == static_cast<std::uint8_t>(Instrument::FUTURE);
+            WriteBook(isFuture ? future : etf, record);
+            converted++;
+        }
+    }
+
+    std::fclose(in);
+    std::fclose(etf);
+    std::fclose(future);
+
+    std::cout << "converted " << converted << " order books" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,588 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Summarises agg captures per interval in a single pass: spread, mid, book
+// imbalance and traded volume of both instruments, the ETF/future basis and,
+// given the simulator's match_events.csv, our own fills. Every input is cut
+// into chunks that are scanned on all cores a round at a time; the results
+// are merged and written out as soon as no later chunk can add to them, so
+// memory use depends on the chunk size and thread count, not on how big the
+// captures are.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "capture.h"
+#include "intervalstats.h"
+#include "recorder.h"
+
+using namespace ReadyTraderGo;
+namespace bip = boost::interprocess;
+
+// Rows of a binary or columnar capture, and bytes of a CSV file, per chunk.
+constexpr std::size_t CHUNK_ROWS = 1 << 16;
+constexpr std::size_t CHUNK_BYTES = 8 << 20;
+constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+constexpr std::uint64_t NO_MORE_ROWS = std::numeric_limits<std::uint64_t>::max();
+
+// One input, cut into chunks whose rows are in time order.
+class StatsSource
+{
+public:
+    virtual ~StatsSource() = default;
+
+    virtual std::size_t ChunkCount() const = 0;
+
+    // Time of the first row of a chunk, in nanoseconds since the epoch.
+    virtual std::uint64_t ChunkStart(std::size_t chunk) const = 0;
+
+    // Add every row of a chunk to the table and return how many there were.
+    // Called from several threads at once, for different chunks.
+    virtual unsigned long Scan(std::size_t chunk, IntervalTable& table) const = 0;
+};
+
+static void MapFile(const std::string& filename, bip::mapped_region& region)
+{
+    try
+    {
+        bip::file_mapping file(filename.c_str(), bip::read_only);
+        region = bip::mapped_region(file, bip::read_only);
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+        throw std::runtime_error("could not map " + filename + ": " + e.what());
+    }
+}
+
+// The recorder's market_data.bin: a RecordFileHeader and then MarketRecords
+// of both instruments and both message types, in the order they arrived.
+class RecordSource : public StatsSource
+{
+public:
+    explicit RecordSource(const std::string& filename)
+    {
+        MapFile(filename, mRegion);
+        const auto* header = static_cast<const RecordFileHeader*>(mRegion.get_address());
+        if (mRegion.get_size() < sizeof(RecordFileHeader)
+            || std::memcmp(header->magic, RECORD_FILE_MAGIC, sizeof(header->magic)) != 0
+            || header->version != RECORD_FILE_VERSION
+            || header->recordSize != sizeof(MarketRecord))
+        {
+            throw std::runtime_error(filename + " is not a capture file this tool understands");
+        }
+        mRecords = reinterpret_cast<const MarketRecord*>(header + 1);
+        mCount = (mRegion.get_size() - sizeof(RecordFileHeader)) / sizeof(MarketRecord);
+    }
+
+    std::size_t ChunkCount() const override { return (mCount + CHUNK_ROWS - 1) / CHUNK_ROWS; }
+
+    std::uint64_t ChunkStart(std::size_t chunk) const override
+    {
+        return mRecords[chunk * CHUNK_ROWS].timestamp;
+    }
+
+    unsigned long Scan(std::size_t chunk, IntervalTable& table) const override
+    {
+        std::size_t end = std::min(mCount, (chunk + 1) * CHUNK_ROWS);
+        for (std::size_t i = chunk * CHUNK_ROWS; i < end; i++)
+        {
+            const MarketRecord& record = mRecords[i];
+            auto instrument = static_cast<Instrument>(record.instrument);
+            IntervalStats& stats = table.At(record.timestamp);
+            if (record.type == static_cast<std::uint8_t>(RecordType::ORDER_BOOK))
+            {
+                stats.AddBook(instrument, record.timestamp, record.askPrices, record.askVolumes,
+                              record.bidPrices, record.bidVolumes);
+            }
+            else
+            {
+                stats.AddTradeTicks(instrument, record.askVolumes, record.bidVolumes);
+            }
+        }
+        return end - chunk * CHUNK_ROWS;
+    }
+
+private:
+    bip::mapped_region mRegion;
+    const MarketRecord* mRecords = nullptr;
+    std::size_t mCount = 0;
+};
+
+// One columnar capture (see capture.h): one instrument, one message type.
+class ColumnarSource : public StatsSource
+{
+public:
+    explicit ColumnarSource(const std::string& filename) : mReader(filename) {}
+
+    std::size_t ChunkCount() const override { return (mReader.Size() + CHUNK_ROWS - 1) / CHUNK_ROWS; }
+
+    std::uint64_t ChunkStart(std::size_t chunk) const override
+    {
+        return mReader.Timestamps()[chunk * CHUNK_ROWS];
+    }
+
+    unsigned long Scan(std::size_t chunk, IntervalTable& table) const override
+    {
+        Instrument instrument = mReader.GetInstrument();
+        bool books = mReader.GetType() == RecordType::ORDER_BOOK;
+        std::size_t end = std::min(mReader.Size(), (chunk + 1) * CHUNK_ROWS);
+        for (std::size_t i = chunk * CHUNK_ROWS; i < end; i++)
+        {
+            CaptureRow row = mReader.Row(i);
+            IntervalStats& stats = table.At(row.timestamp);
+            if (books)
+            {
+                stats.AddBook(instrument, row.timestamp, row.askPrices, row.askVolumes,
+                              row.bidPrices, row.bidVolumes);
+            }
+            else
+            {
+                stats.AddTradeTicks(instrument, row.askVolumes, row.bidVolumes);
+            }
+        }
+        return end - chunk * CHUNK_ROWS;
+    }
+
+private:
+    CaptureReader mReader;
+};
+
+// Reads an unsigned number at p, never past end, and steps over it and the
+// separator after it.
+static unsigned long ParseNumber(const char*& p, const char* end)
+{
+    unsigned long value = 0;
+    while (p != end && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + static_cast<unsigned long>(*p++ - '0');
+    }
+    if (p != end && *p == ',')
+    {
+        p++;
+    }
+    return value;
+}
+
+static const char* NextLine(const char* p, const char* end)
+{
+    p = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return p == nullptr ? end : p + 1;
+}
+
+// An order book CSV in capture_convert's layout, one instrument per file:
+// "epoch_ms,ask_price,ask_volume,...,bid_price,bid_volume,...". Which
+// instrument it holds is taken from "etf" or "future" in the file name.
+class CsvBookSource : public StatsSource
+{
+public:
+    explicit CsvBookSource(const std::string& filename)
+    {
+        std::string name = filename.substr(filename.find_last_of('/') + 1);
+        if (name.find("future") != std::string::npos)
+        {
+            mInstrument = Instrument::FUTURE;
+        }
+        else if (name.find("etf") == std::string::npos)
+        {
+            throw std::runtime_error("cannot tell the instrument of " + filename
+                                     + "; its name should contain etf or future");
+        }
+
+        MapFile(filename, mRegion);
+        mBegin = static_cast<const char*>(mRegion.get_address());
+        mEnd = mBegin + mRegion.get_size();
+
+        // Chunks start on line boundaries.
+        for (const char* p = mBegin; p != mEnd;
+             p = NextLine(mEnd - p > static_cast<std::ptrdiff_t>(CHUNK_BYTES) ? p + CHUNK_BYTES : mEnd - 1, mEnd))
+        {
+            mChunks.push_back(p);
+        }
+        mChunks.push_back(mEnd);
+    }
+
+    std::size_t ChunkCount() const override { return mChunks.size() - 1; }
+
+    std::uint64_t ChunkStart(std::size_t chunk) const override
+    {
+        const char* p = mChunks[chunk];
+        while (p != mEnd && !IsRow(p))
+        {
+            p = NextLine(p, mEnd);
+        }
+        return ParseNumber(p, mEnd) * 1000000;
+    }
+
+    unsigned long Scan(std::size_t chunk, IntervalTable& table) const override
+    {
+        unsigned long rows = 0;
+        const char* end = mChunks[chunk + 1];
+        for (const char* p = mChunks[chunk]; p != end; p = NextLine(p, end))
+        {
+            if (!IsRow(p))
+            {
+                continue; // a header or a blank line
+            }
+            CaptureLevels askPrices, askVolumes, bidPrices, bidVolumes;
+            std::uint64_t time = ParseNumber(p, end) * 1000000;
+            for (int i = 0; i < TOP_LEVEL_COUNT; i++)
+            {
+                askPrices[i] = ParseNumber(p, end);
+                askVolumes[i] = ParseNumber(p, end);
+            }
+            for (int i = 0; i < TOP_LEVEL_COUNT; i++)
+            {
+                bidPrices[i] = ParseNumber(p, end);
+                bidVolumes[i] = ParseNumber(p, end);
+            }
+            table.At(time).AddBook(mInstrument, time, askPrices, askVolumes, bidPrices, bidVolumes);
+            rows++;
+        }
+        return rows;
+    }
+
+private:
+    static bool IsRow(const char* line) { return *line >= '0' && *line <= '9'; }
+
+    Instrument mInstrument = Instrument::ETF;
+    bip::mapped_region mRegion;
+    const char* mBegin = nullptr;
+    const char* mEnd = nullptr;
+    std::vector<const char*> mChunks;
+};
+
+// One competitor's fills from the simulator's match_events.csv. Its times
+// are seconds from the start of the match, which is taken to be the first
+// row of the market data.
+class FillSource : public StatsSource
+{
+public:
+    FillSource(const std::string& filename, const std::string& competitor, std::uint64_t origin)
+    {
+        std::ifstream in(filename);
+        std::string line;
+        if (!in || !std::getline(in, line))
+        {
+            throw std::runtime_error("could not read " + filename);
+        }
+
+        std::vector<std::string> fields = Split(line);
+        auto column = [&](const char* name) {
+            auto found = std::find(fields.begin(), fields.end(), name);
+            if (found == fields.end())
+            {
+                throw std::runtime_error(filename + " has no " + name + " column");
+            }
+            return static_cast<std::size_t>(found - fields.begin());
+        };
+        std::size_t time = column("Time"), name = column("Competitor"), operation = column("Operation");
+        std::size_t side = column("Side"), volume = column("Volume"), price = column("Price");
+        std::size_t fee = column("Fee");
+        std::size_t width = std::max({time, name, operation, side, volume, price, fee}) + 1;
+
+        while (std::getline(in, line))
+        {
+            fields = Split(line);
+            if (fields.size() < width || fields[operation] != "Fill" || fields[name] != competitor)
+            {
+                continue;
+            }
+            Fill fill;
+            fill.time = origin + static_cast<std::uint64_t>(std::stod(fields[time]) * 1e9);
+            const std::string& sideName = fields[side];
+            bool buy = sideName == "B" || sideName == "BUY" || sideName == "Buy" || sideName == "1";
+            fill.side = buy ? Side::BUY : Side::SELL;
+            fill.price = std::stoul(fields[price]);
+            fill.volume = std::stoul(fields[volume]);
+            fill.fee = fields[fee].empty() ? 0 : std::stod(fields[fee]);
+            mFills.push_back(fill);
+        }
+    }
+
+    std::size_t ChunkCount() const override { return (mFills.size() + CHUNK_ROWS - 1) / CHUNK_ROWS; }
+
+    std::uint64_t ChunkStart(std::size_t chunk) const override { return mFills[chunk * CHUNK_ROWS].time; }
+
+    unsigned long Scan(std::size_t chunk, IntervalTable& table) const override
+    {
+        std::size_t end = std::min(mFills.size(), (chunk + 1) * CHUNK_ROWS);
+        for (std::size_t i = chunk * CHUNK_ROWS; i < end; i++)
+        {
+            const Fill& fill = mFills[i];
+            table.At(fill.time).AddFill(fill.side, fill.price, fill.volume, fill.fee);
+        }
+        return end - chunk * CHUNK_ROWS;
+    }
+
+private:
+    struct Fill
+    {
+        std::uint64_t time;
+        Side side;
+        unsigned long price;
+        unsigned long volume;
+        double fee;
+    };
+
+    static std::vector<std::string> Split(const std::string& line)
+    {
+        std::vector<std::string> fields;
+        std::size_t start = 0;
+        for (std::size_t comma; (comma = line.find(',', start)) != std::string::npos; start = comma + 1)
+        {
+            fields.push_back(line.substr(start, comma - start));
+        }
+        fields.push_back(line.substr(start, line.find_last_not_of("\r\n") + 1 - start));
+        return fields;
+    }
+
+    std::vector<Fill> mFills;
+};
+
+static std::unique_ptr<StatsSource> OpenSource(const std::string& filename)
+{
+    auto endsWith = [&filename](const char* suffix) {
+        std::size_t length = std::strlen(suffix);
+        return filename.size() >= length && filename.compare(filename.size() - length, length, suffix) == 0;
+    };
+    if (endsWith(".bin"))
+    {
+        return std::make_unique<RecordSource>(filename);
+    }
+    if (endsWith(".col"))
+    {
+        return std::make_unique<ColumnarSource>(filename);
+    }
+    if (endsWith(".csv"))
+    {
+        return std::make_unique<CsvBookSource>(filename);
+    }
+    throw std::runtime_error("do not know how to read " + filename + " (expected .bin, .col or .csv)");
+}
+
+struct ChunkRef
+{
+    const StatsSource* source;
+    std::size_t chunk;
+};
+
+// Scan a round of chunks on up to threads threads, each into its own table.
+static unsigned long ScanRound(const std::vector<ChunkRef>& round,
+                               std::vector<IntervalTable>& tables,
+                               std::size_t threads)
+{
+    std::atomic<std::size_t> next{0};
+    std::atomic<unsigned long> rows{0};
+    auto work = [&] {
+        for (std::size_t i; (i = next.fetch_add(1)) < round.size();)
+        {
+            rows += round[i].source->Scan(round[i].chunk, tables[i]);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < std::min(threads, round.size()); i++)
+    {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    return rows;
+}
+
+static void Usage(const char* name)
+{
+    std::cerr << "usage: " << name << " [options] INPUT...\n"
+              << "  INPUT                market_data.bin, a columnar .col capture or a capture_convert\n"
+              << "                       .csv with etf or future in its name\n"
+              << "  --interval SECONDS   length of each summary interval (default 1)\n"
+              << "  --fills FILE         match_events.csv to take our fills from\n"
+              << "  --competitor NAME    our team name in the match events\n"
+              << "  --output FILE        where to write the summary (default capture_stats.csv)\n"
+              << "  --threads N          worker threads (default: all cores)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    double interval = 1;
+    std::string fillsFile;
+    std::string competitor;
+    std::string outputFile = "capture_stats.csv";
+    std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+
+    try
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0)
+            {
+                inputs.push_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            std::string value = argv[++i];
+            if (arg == "--interval")
+            {
+                interval = std::stod(value);
+            }
+            else if (arg == "--fills")
+            {
+                fillsFile = value;
+            }
+            else if (arg == "--competitor")
+            {
+                competitor = value;
+            }
+            else if (arg == "--output")
+            {
+                outputFile = value;
+            }
+            else if (arg == "--threads")
+            {
+                threads = std::max<std::size_t>(1, std::stoul(value));
+            }
+            else
+            {
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        if (inputs.empty() || interval <= 0 || fillsFile.empty() != competitor.empty())
+        {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::unique_ptr<StatsSource>> sources;
+        std::uint64_t origin = NO_MORE_ROWS;
+        for (const std::string& input : inputs)
+        {
+            sources.push_back(OpenSource(input));
+            if (sources.back()->ChunkCount() != 0)
+            {
+                origin = std::min(origin, sources.back()->ChunkStart(0));
+            }
+        }
+        if (!fillsFile.empty() && origin != NO_MORE_ROWS)
+        {
+            sources.push_back(std::make_unique<FillSource>(fillsFile, competitor, origin));
+        }
+
+        std::FILE* out = std::fopen(outputFile.c_str(), "w");
+        if (out == nullptr)
+        {
+            std::cerr << "could not open " << outputFile << std::endl;
+            return EXIT_FAILURE;
+        }
+        IntervalTable::WriteCsvHeader(out);
+
+        auto intervalNs = static_cast<std::uint64_t>(interval * 1e9);
+        IntervalTable pending(intervalNs);
+        std::vector<std::size_t> next(sources.size(), 0);
+        auto nextStart = [&](std::size_t s) {
+            return next[s] < sources[s]->ChunkCount() ? sources[s]->ChunkStart(next[s]) : NO_MORE_ROWS;
+        };
+
+        unsigned long rows = 0;
+        unsigned long intervals = 0;
+        std::uint64_t frontier = 0;
+        while (frontier != NO_MORE_ROWS)
+        {
+            // The earliest chunks of every source, so that the round covers
+            // one stretch of time and as much of it as possible can be
+            // written out afterwards.
+            std::vector<ChunkRef> round;
+            while (round.size() < threads * CHUNKS_PER_THREAD)
+            {
+                std::size_t earliest = 0;
+                for (std::size_t s = 1; s < sources.size(); s++)
+                {
+                    earliest = nextStart(s) < nextStart(earliest) ? s : earliest;
+                }
+                if (nextStart(earliest) == NO_MORE_ROWS)
+                {
+                    break;
+                }
+                round.push_back({sources[earliest].get(), next[earliest]++});
+            }
+
+            std::vector<IntervalTable> tables;
+            tables.reserve(round.size());
+            for (std::size_t i = 0; i < round.size(); i++)
+            {
+                tables.emplace_back(intervalNs);
+            }
+            rows += ScanRound(round, tables, threads);
+            for (const IntervalTable& table : tables)
+            {
+                pending.Merge(table);
+            }
+
+            // Nothing left to scan starts before the frontier.
+            frontier = NO_MORE_ROWS;
+            for (std::size_t s = 0; s < sources.size(); s++)
+            {
+                frontier = std::min(frontier, nextStart(s));
+            }
+            intervals += pending.Flush(out, frontier);
+        }
+
+        if (std::fclose(out) != 0)
+        {
+            std::cerr << "could not write " << outputFile << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "summarised " << rows << " rows from " << sources.size() << " inputs into " << intervals
+                  << " intervals in " << elapsed.count() << "s" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
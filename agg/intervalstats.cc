@@ -0,0 +1,178 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include "intervalstats.h"
+
+using namespace ReadyTraderGo;
+
+void IntervalStats::AddBook(Instrument instrument,
+                            std::uint64_t time,
+                            const CaptureLevels& askPrices,
+                            const CaptureLevels& askVolumes,
+                            const CaptureLevels& bidPrices,
+                            const CaptureLevels& bidVolumes)
+{
+    BookStats& stats = instruments[static_cast<std::size_t>(instrument)];
+    stats.books++;
+    if (askPrices[0] == 0 || bidPrices[0] == 0)
+    {
+        return;
+    }
+
+    stats.twoSidedBooks++;
+    stats.spreadSum += static_cast<double>(askPrices[0]) - static_cast<double>(bidPrices[0]);
+    unsigned long topVolume = askVolumes[0] + bidVolumes[0];
+    if (topVolume != 0)
+    {
+        stats.imbalanceSum += (static_cast<double>(bidVolumes[0]) - static_cast<double>(askVolumes[0])) / topVolume;
+    }
+    if (time >= stats.lastMidTime)
+    {
+        stats.lastMid = (static_cast<double>(askPrices[0]) + static_cast<double>(bidPrices[0])) / 2;
+        stats.lastMidTime = time;
+    }
+}
+
+void IntervalStats::AddTradeTicks(Instrument instrument,
+                                  const CaptureLevels& askVolumes,
+                                  const CaptureLevels& bidVolumes)
+{
+    BookStats& stats = instruments[static_cast<std::size_t>(instrument)];
+    stats.tradeTicks++;
+    for (int i = 0; i < TOP_LEVEL_COUNT; i++)
+    {
+        stats.tradedVolume += askVolumes[i] + bidVolumes[i];
+    }
+}
+
+void IntervalStats::AddFill(Side side, unsigned long price, unsigned long volume, double fee)
+{
+    fills.fills++;
+    (side == Side::BUY ? fills.buyVolume : fills.sellVolume) += volume;
+    fills.notional += static_cast<double>(price) * volume;
+    fills.fees += fee;
+}
+
+void IntervalStats::Merge(const IntervalStats& other)
+{
+    for (std::size_t i = 0; i < instruments.size(); i++)
+    {
+        BookStats& stats = instruments[i];
+        const BookStats& more = other.instruments[i];
+        stats.books += more.books;
+        stats.twoSidedBooks += more.twoSidedBooks;
+        stats.spreadSum += more.spreadSum;
+        stats.imbalanceSum += more.imbalanceSum;
+        if (more.lastMidTime > stats.lastMidTime)
+        {
+            stats.lastMid = more.lastMid;
+            stats.lastMidTime = more.lastMidTime;
+        }
+        stats.tradeTicks += more.tradeTicks;
+        stats.tradedVolume += more.tradedVolume;
+    }
+
+    fills.fills += other.fills.fills;
+    fills.buyVolume += other.fills.buyVolume;
+    fills.sellVolume += other.fills.sellVolume;
+    fills.notional += other.fills.notional;
+    fills.fees += other.fills.fees;
+}
+
+IntervalStats& IntervalTable::At(std::uint64_t time)
+{
+    std::uint64_t index = time / mInterval;
+    if (mLastStats == nullptr || index != mLastIndex)
+    {
+        mLastIndex = index;
+        mLastStats = &mStats[index];
+    }
+    return *mLastStats;
+}
+
+void IntervalTable::Merge(const IntervalTable& other)
+{
+    for (const auto& [index, stats] : other.mStats)
+    {
+        mStats[index].Merge(stats);
+    }
+}
+
+void IntervalTable::WriteCsvHeader(std::FILE* out)
+{
+    std::fputs("epoch_ms", out);
+    for (const char* instrument : {"etf", "future"})
+    {
+        std::fprintf(out, ",%s_books,%s_mid,%s_spread,%s_imbalance,%s_trade_ticks,%s_traded_volume",
+                     instrument, instrument, instrument, instrument, instrument, instrument);
+    }
+    std::fputs(",basis_bps,fills,buy_volume,sell_volume,fill_vwap,fees\n", out);
+}
+
+// Averages and latest values are left empty for intervals with nothing to
+// take them from.
+static void WriteOptional(std::FILE* out, bool present, double value)
+{
+    if (present)
+    {
+        std::fprintf(out, ",%.4f", value);
+    }
+    else
+    {
+        std::fputc(',', out);
+    }
+}
+
+unsigned long IntervalTable::Flush(std::FILE* out, std::uint64_t time)
+{
+    unsigned long written = 0;
+    auto end = mStats.begin();
+    while (end != mStats.end() && (end->first + 1) * mInterval <= time)
+    {
+        const IntervalStats& stats = end->second;
+        std::fprintf(out, "%llu", static_cast<unsigned long long>(end->first * mInterval / 1000000));
+        for (Instrument instrument : {Instrument::ETF, Instrument::FUTURE})
+        {
+            const BookStats& book = stats.instruments[static_cast<std::size_t>(instrument)];
+            bool twoSided = book.twoSidedBooks != 0;
+            std::fprintf(out, ",%lu", book.books);
+            WriteOptional(out, book.lastMidTime != 0, book.lastMid);
+            WriteOptional(out, twoSided, twoSided ? book.spreadSum / book.twoSidedBooks : 0);
+            WriteOptional(out, twoSided, twoSided ? book.imbalanceSum / book.twoSidedBooks : 0);
+            std::fprintf(out, ",%lu,%lu", book.tradeTicks, book.tradedVolume);
+        }
+
+        const BookStats& etf = stats.instruments[static_cast<std::size_t>(Instrument::ETF)];
+        const BookStats& future = stats.instruments[static_cast<std::size_t>(Instrument::FUTURE)];
+        bool basis = etf.lastMidTime != 0 && future.lastMidTime != 0;
+        WriteOptional(out, basis, basis ? (etf.lastMid - future.lastMid) / future.lastMid * 10000 : 0);
+
+        const FillStats& fills = stats.fills;
+        unsigned long volume = fills.buyVolume + fills.sellVolume;
+        std::fprintf(out, ",%lu,%lu,%lu", fills.fills, fills.buyVolume, fills.sellVolume);
+        WriteOptional(out, volume != 0, volume != 0 ? fills.notional / volume : 0);
+        std::fprintf(out, ",%.2f\n", fills.fees);
+
+        ++end;
+        written++;
+    }
+
+    mStats.erase(mStats.begin(), end);
+    mLastStats = nullptr;
+    return written;
+}
@@ -0,0 +1,114 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_INTERVALSTATS_H
+#define CPPREADY_TRADER_GO_INTERVALSTATS_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+
+#include <ready_trader_go/types.h>
+
+#include "capture.h"
+
+// Per-interval market and fill statistics for capture_stats.
+//
+// Every field is a sum, a count or a latest value stamped with its time, so
+// the statistics of any two sets of rows merge into those of both whatever
+// order they were gathered in. That is what lets capture_stats scan chunks
+// of a capture on separate threads and combine the results afterwards.
+
+struct BookStats
+{
+    unsigned long books = 0;
+    unsigned long twoSidedBooks = 0;
+    double spreadSum = 0;          // cents, over two-sided books
+    double imbalanceSum = 0;       // top level, over two-sided books
+    double lastMid = 0;            // cents
+    std::uint64_t lastMidTime = 0; // nanoseconds; zero if there is no mid yet
+
+    unsigned long tradeTicks = 0;
+    unsigned long tradedVolume = 0;
+};
+
+struct FillStats
+{
+    unsigned long fills = 0;
+    unsigned long buyVolume = 0;
+    unsigned long sellVolume = 0;
+    double notional = 0;           // cents
+    double fees = 0;
+};
+
+struct IntervalStats
+{
+    std::array<BookStats, 2> instruments; // indexed by ReadyTraderGo::Instrument
+    FillStats fills;
+
+    void AddBook(ReadyTraderGo::Instrument instrument,
+                 std::uint64_t time,
+                 const CaptureLevels& askPrices,
+                 const CaptureLevels& askVolumes,
+                 const CaptureLevels& bidPrices,
+                 const CaptureLevels& bidVolumes);
+    void AddTradeTicks(ReadyTraderGo::Instrument instrument,
+                       const CaptureLevels& askVolumes,
+                       const CaptureLevels& bidVolumes);
+    void AddFill(ReadyTraderGo::Side side, unsigned long price, unsigned long volume, double fee);
+
+    void Merge(const IntervalStats& other);
+};
+
+// Statistics keyed by interval number: the time divided by the interval.
+//
+// Rows mostly arrive in time order, so the interval last added to is
+// remembered and found again without a lookup.
+class IntervalTable
+{
+public:
+    explicit IntervalTable(std::uint64_t interval) : mInterval(interval) {}
+
+    // Moving keeps the map's nodes, and with them mLastStats, in place.
+    IntervalTable(IntervalTable&&) = default;
+    IntervalTable& operator=(IntervalTable&&) = default;
+    IntervalTable(const IntervalTable&) = delete;
+    IntervalTable& operator=(const IntervalTable&) = delete;
+
+    std::uint64_t Interval() const { return mInterval; }
+    bool Empty() const { return mStats.empty(); }
+
+    IntervalStats& At(std::uint64_t time);
+
+    void Merge(const IntervalTable& other);
+
+    // Write every interval that ends at or before time as a CSV line, and
+    // forget it. Returns the number of lines written.
+    unsigned long Flush(std::FILE* out, std::uint64_t time);
+
+    static void WriteCsvHeader(std::FILE* out);
+
+private:
+    std::uint64_t mInterval;
+    std::map<std::uint64_t, IntervalStats> mStats;
+    std::uint64_t mLastIndex = 0;
+    IntervalStats* mLastStats = nullptr;
+};
+
+#endif //CPPREADY_TRADER_GO_INTERVALSTATS_H
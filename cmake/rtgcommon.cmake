@@ -0,0 +1,102 @@
+# Settings, libraries and options shared by every bot. Included once, either
+# by the top-level CMakeLists.txt or by a bot's own when that bot is
+# configured on its own, as in the Ready Trader Go archive.
+include_guard(GLOBAL)
+
+get_filename_component(RTG_ROOT_DIR ${CMAKE_CURRENT_LIST_DIR} DIRECTORY)
+
+set(CMAKE_CXX_STANDARD 17)
+set(CMAKE_CXX_STANDARD_REQUIRED ON)
+set(CMAKE_CXX_EXTENSIONS OFF)
+
+if(MSVC)
+    add_compile_options(/W3)
+else()
+    add_compile_options(-Wall)
+endif()
+
+find_package(Boost 1.74 COMPONENTS date_time log system thread
+        OPTIONAL_COMPONENTS container graph math_c99 math_c99f math_tr1
+        math_tr1f random regex timer unit_test_framework)
+if(NOT ${Boost_FOUND})
+    message(FATAL_ERROR
+            "Ready Trader Go requires the free Boost C++ libraries version "
+            "1.74 or above. See https://www.boost.org/.")
+endif()
+
+find_package(Threads REQUIRED)
+
+add_compile_definitions(BOOST_LOG_DYN_LINK=1)
+
+include_directories(${Boost_INCLUDE_DIRS})
+link_directories(${Boost_LIBRARY_DIRS})
+
+# Link-time optimisation, so that the hot path is inlined across translation
+# units, rtg_core's included.
+option(RTG_LTO "Build with link-time optimisation" OFF)
+if(RTG_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT RTG_LTO_SUPPORTED OUTPUT RTG_LTO_ERROR)
+    if(RTG_LTO_SUPPORTED)
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+    else()
+        message(WARNING "Link-time optimisation is not supported: ${RTG_LTO_ERROR}")
+    endif()
+endif()
+
+# Profile-guided optimisation: GENERATE builds instrumented binaries that
+# write profiles to RTG_PGO_DIR when they exit, USE builds with them. GCC
+# matches profiles to object files by path, so both stages must build in the
+# same directory; Clang's raw profiles must first be merged into
+# RTG_PGO_DIR/default.profdata with llvm-profdata.
+set(RTG_PGO OFF CACHE STRING "Profile-guided optimisation (OFF, GENERATE or USE)")
+set_property(CACHE RTG_PGO PROPERTY STRINGS OFF GENERATE USE)
+set(RTG_PGO_DIR ${CMAKE_BINARY_DIR}/pgo CACHE PATH "Where profile-guided optimisation profiles are written and read")
+if(RTG_PGO STREQUAL "GENERATE")
+    add_compile_options(-fprofile-generate=${RTG_PGO_DIR} -fprofile-update=atomic)
+    add_link_options(-fprofile-generate=${RTG_PGO_DIR})
+elseif(RTG_PGO STREQUAL "USE")
+    if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        add_compile_options(-fprofile-use=${RTG_PGO_DIR} -Wno-profile-instr-unprofiled)
+    else()
+        add_compile_options(-fprofile-use=${RTG_PGO_DIR} -fprofile-correction -Wno-missing-profile
+                -Wno-error=coverage-mismatch)
+    endif()
+    add_link_options(-fprofile-use=${RTG_PGO_DIR})
+elseif(NOT RTG_PGO STREQUAL "OFF")
+    message(FATAL_ERROR "RTG_PGO must be OFF, GENERATE or USE, not ${RTG_PGO}")
+endif()
+
+# Debug builds can count (COUNT) or abort on (ABORT) heap allocations made
+# inside the handlers that must not allocate; see core/allocationcheck.h.
+set(AUTOTRADER_ALLOCATION_CHECK OFF CACHE STRING "Check for heap allocations on the autotrader hot path (OFF, COUNT or ABORT)")
+
+function(rtg_allocation_check target scope mode)
+    if(NOT ${mode} STREQUAL "OFF")
+        target_compile_definitions(${target} ${scope} RTG_ALLOCATION_CHECK=1)
+    endif()
+    if(${mode} STREQUAL "ABORT")
+        target_compile_definitions(${target} ${scope} RTG_ALLOCATION_CHECK_ABORT=1)
+    endif()
+endfunction()
+
+# The Ready Trader Go library, built once for every bot. A bot configured on
+# its own uses the libs directory beside it.
+if(NOT RTG_LIBS_DIR)
+    foreach(candidate ${CMAKE_SOURCE_DIR}/libs ${RTG_ROOT_DIR}/strategy/libs
+            ${RTG_ROOT_DIR}/agg/libs)
+        if(EXISTS ${candidate}/CMakeLists.txt)
+            set(RTG_LIBS_DIR ${candidate})
+            break()
+        endif()
+    endforeach()
+endif()
+set(RTG_LIBS_DIR ${RTG_LIBS_DIR} CACHE PATH "Ready Trader Go libs directory")
+if(NOT RTG_LIBS_DIR)
+    message(FATAL_ERROR "Could not find the Ready Trader Go libs directory; set RTG_LIBS_DIR.")
+endif()
+
+add_subdirectory(${RTG_LIBS_DIR} ${CMAKE_BINARY_DIR}/libs)
+include_directories(${RTG_LIBS_DIR})
+
+add_subdirectory(${RTG_ROOT_DIR}/core ${CMAKE_BINARY_DIR}/core)
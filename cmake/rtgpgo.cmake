@@ -0,0 +1,62 @@
+# Builds autotrader_pgo, run as a script (cmake -P) by the strategy's
+# autotrader_pgo target:
+#
+#   1. configures the strategy on its own in PGO_BINARY_DIR with RTG_PGO set
+#      to GENERATE and builds autotrader_pgo, which in that stage is the
+#      backtest harness instrumented to write profiles;
+#   2. trains it by replaying PGO_CAPTURE;
+#   3. reconfigures the same directory with RTG_PGO set to USE and builds
+#      autotrader_pgo again, now the autotrader, optimised with the profiles;
+#   4. copies the result to PGO_OUTPUT_DIR.
+#
+# Both stages compile the AutoTrader and rtg_core sources to the same object
+# files, which is how GCC finds their profiles. Expects PGO_SOURCE_DIR,
+# PGO_BINARY_DIR, PGO_CAPTURE, PGO_EXCHANGE, PGO_OUTPUT_DIR, PGO_CXX_COMPILER,
+# PGO_LIBS_DIR, PGO_HOT_LOG_LEVEL, PGO_DEFERRED_LOG and, for Clang,
+# PGO_PROFDATA.
+cmake_minimum_required(VERSION 3.17)
+
+set(profiles ${PGO_BINARY_DIR}/profiles)
+
+function(rtg_pgo_run description)
+    message(STATUS "autotrader_pgo: ${description}")
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "autotrader_pgo: ${description} failed (${result})")
+    endif()
+endfunction()
+
+function(rtg_pgo_stage stage)
+    rtg_pgo_run("configuring the ${stage} stage"
+            ${CMAKE_COMMAND} -S ${PGO_SOURCE_DIR} -B ${PGO_BINARY_DIR}
+            -DCMAKE_BUILD_TYPE=Release
+            -DCMAKE_CXX_COMPILER=${PGO_CXX_COMPILER}
+            -DRTG_LIBS_DIR=${PGO_LIBS_DIR}
+            -DRTG_LTO=ON
+            -DRTG_PGO=${stage}
+            -DRTG_PGO_DIR=${profiles}
+            -DAUTOTRADER_HOT_LOG_LEVEL=${PGO_HOT_LOG_LEVEL}
+            -DAUTOTRADER_DEFERRED_LOG=${PGO_DEFERRED_LOG}
+            -DAUTOTRADER_ALLOCATION_CHECK=OFF
+            -DAUTOTRADER_PGO_CAPTURE=)
+    rtg_pgo_run("building the ${stage} stage"
+            ${CMAKE_COMMAND} --build ${PGO_BINARY_DIR} --target autotrader_pgo)
+endfunction()
+
+rtg_pgo_stage(GENERATE)
+
+# Profiles from an earlier run would be added to this one's.
+file(REMOVE_RECURSE ${profiles})
+file(MAKE_DIRECTORY ${profiles})
+rtg_pgo_run("training on ${PGO_CAPTURE}"
+        ${PGO_BINARY_DIR}/autotrader_pgo ${PGO_CAPTURE} ${PGO_EXCHANGE})
+
+if(PGO_PROFDATA)
+    file(GLOB raw ${profiles}/*.profraw)
+    rtg_pgo_run("merging profiles"
+            ${PGO_PROFDATA} merge -output=${profiles}/default.profdata ${raw})
+endif()
+
+rtg_pgo_stage(USE)
+
+file(COPY ${PGO_BINARY_DIR}/autotrader_pgo DESTINATION ${PGO_OUTPUT_DIR})
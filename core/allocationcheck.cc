@@ -0,0 +1,127 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "allocationcheck.h"
+
+#ifdef RTG_ALLOCATION_CHECK
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local unsigned int tHotPathDepth = 0;
+std::atomic<unsigned long> gHotPathAllocations{0};
+
+void CheckAllocation(std::size_t size) {
+    if (tHotPathDepth == 0) {
+        return;
+    }
+    gHotPathAllocations.fetch_add(1, std::memory_order_relaxed);
+#ifdef RTG_ALLOCATION_CHECK_ABORT
+    // Nothing here may allocate.
+    std::fprintf(stderr, "allocation of %zu bytes on the hot path\n", size);
+    std::abort();
+#else
+    (void)size;
+#endif
+}
+
+void *Allocate(std::size_t size) {
+    CheckAllocation(size);
+    void *p = std::malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *AllocateAligned(std::size_t size, std::align_val_t alignment) {
+    CheckAllocation(size);
+    auto align = static_cast<std::size_t>(alignment);
+    void *p = std::aligned_alloc(align, (size + align - 1) / align * align);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+HotPathScope::HotPathScope() { tHotPathDepth++; }
+
+HotPathScope::~HotPathScope() { tHotPathDepth--; }
+
+HotPathExempt::HotPathExempt() : mDepth(tHotPathDepth) { tHotPathDepth = 0; }
+
+HotPathExempt::~HotPathExempt() { tHotPathDepth = mDepth; }
+
+unsigned long HotPathAllocations() {
+    return gHotPathAllocations.load(std::memory_order_relaxed);
+}
+
+void *operator new(std::size_t size) { return Allocate(size); }
+
+void *operator new[](std::size_t size) { return Allocate(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return Allocate(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return Allocate(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return AllocateAligned(size, alignment);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif // RTG_ALLOCATION_CHECK
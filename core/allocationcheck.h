@@ -0,0 +1,80 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_ALLOCATIONCHECK_H
+#define CPPREADY_TRADER_GO_ALLOCATIONCHECK_H
+
+// Verification that the hot path does not allocate.
+//
+// Handlers that must not allocate open a HotPathScope. With
+// RTG_ALLOCATION_CHECK defined (the AUTOTRADER_ALLOCATION_CHECK CMake
+// option), allocationcheck.cc replaces the global operator new and counts
+// every allocation made on a thread while it has a scope open; with
+// RTG_ALLOCATION_CHECK_ABORT as well, the first such allocation aborts the
+// process instead, so a debugger or core dump shows who made it. Without
+// the option the scopes are empty and the count is always zero.
+
+#ifdef RTG_ALLOCATION_CHECK
+
+class HotPathScope {
+public:
+    HotPathScope();
+    ~HotPathScope();
+
+    HotPathScope(const HotPathScope &) = delete;
+    HotPathScope &operator=(const HotPathScope &) = delete;
+};
+
+// Suspends the check on this thread for work done on the trader's behalf
+// that is not part of its own hot path, such as the backtest's simulated
+// exchange; scopes opened inside it count again.
+class HotPathExempt {
+public:
+    HotPathExempt();
+    ~HotPathExempt();
+
+    HotPathExempt(const HotPathExempt &) = delete;
+    HotPathExempt &operator=(const HotPathExempt &) = delete;
+
+private:
+    unsigned int mDepth;
+};
+
+// Allocations made inside a HotPathScope, on any thread, so far.
+unsigned long HotPathAllocations();
+
+#else
+
+class HotPathScope {
+public:
+    HotPathScope() {}
+    HotPathScope(const HotPathScope &) = delete;
+    HotPathScope &operator=(const HotPathScope &) = delete;
+};
+
+class HotPathExempt {
+public:
+    HotPathExempt() {}
+    HotPathExempt(const HotPathExempt &) = delete;
+    HotPathExempt &operator=(const HotPathExempt &) = delete;
+};
+
+inline unsigned long HotPathAllocations() { return 0; }
+
+#endif
+
+#endif // CPPREADY_TRADER_GO_ALLOCATIONCHECK_H
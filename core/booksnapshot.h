@@ -0,0 +1,85 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_BOOKSNAPSHOT_H
+#define CPPREADY_TRADER_GO_BOOKSNAPSHOT_H
+
+#include <array>
+
+#include <ready_trader_go/types.h>
+
+// What differs between two consecutive books, as a set of flags.
+enum BookChange : unsigned {
+    BOOK_UNCHANGED = 0,
+    // The best ask price.
+    ASK_BEST = 1u << 0,
+    // Any ask price.
+    ASK_PRICES = 1u << 1,
+    // Any price or volume on the ask side.
+    ASK_LEVELS = 1u << 2,
+    BID_BEST = 1u << 3,
+    BID_PRICES = 1u << 4,
+    BID_LEVELS = 1u << 5
+};
+
+// The last book seen for one instrument.
+struct BookSnapshot {
+    using Levels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+    Levels askPrices{};
+    Levels askVolumes{};
+    Levels bidPrices{};
+    Levels bidVolumes{};
+
+    // Replace the snapshot with a new book and return what changed.
+    unsigned Update(const Levels &newAskPrices, const Levels &newAskVolumes,
+                    const Levels &newBidPrices, const Levels &newBidVolumes) {
+        unsigned long askBest = askPrices[0] ^ newAskPrices[0];
+        unsigned long bidBest = bidPrices[0] ^ newBidPrices[0];
+        unsigned long askPricesDiffer = Differ(askPrices, newAskPrices);
+        unsigned long bidPricesDiffer = Differ(bidPrices, newBidPrices);
+        unsigned long askLevels =
+            askPricesDiffer | Differ(askVolumes, newAskVolumes);
+        unsigned long bidLevels =
+            bidPricesDiffer | Differ(bidVolumes, newBidVolumes);
+
+        askPrices = newAskPrices;
+        askVolumes = newAskVolumes;
+        bidPrices = newBidPrices;
+        bidVolumes = newBidVolumes;
+
+        return (askBest != 0 ? ASK_BEST : 0) |
+               (askPricesDiffer != 0 ? ASK_PRICES : 0) |
+               (askLevels != 0 ? ASK_LEVELS : 0) |
+               (bidBest != 0 ? BID_BEST : 0) |
+               (bidPricesDiffer != 0 ? BID_PRICES : 0) |
+               (bidLevels != 0 ? BID_LEVELS : 0);
+    }
+
+private:
+    // Non-zero if any level differs. There are no branches in the loop, so
+    // the compiler unrolls it into a few vector XORs and ORs.
+    static unsigned long Differ(const Levels &a, const Levels &b) {
+        unsigned long diff = 0;
+        for (std::size_t i = 0; i < ReadyTraderGo::TOP_LEVEL_COUNT; i++) {
+            diff |= a[i] ^ b[i];
+        }
+        return diff;
+    }
+};
+
+#endif // CPPREADY_TRADER_GO_BOOKSNAPSHOT_H
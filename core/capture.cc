@@ -0,0 +1,213 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "capture.h"
+
+using namespace ReadyTraderGo;
+namespace bip = boost::interprocess;
+
+static_assert(sizeof(CaptureHeader) <= CAPTURE_HEADER_SIZE, "capture header too large");
+
+constexpr std::size_t COLUMN_ALIGNMENT = 64;
+
+constexpr std::size_t COLUMN_WIDTHS[CC_COLUMN_COUNT] = {
+    sizeof(std::uint64_t),
+    sizeof(unsigned long),
+    sizeof(CaptureLevels),
+    sizeof(CaptureLevels),
+    sizeof(CaptureLevels),
+    sizeof(CaptureLevels),
+};
+
+// Fill in the column offsets for the given capacity and return the file size.
+static std::uint64_t Layout(std::uint64_t capacity, std::uint64_t* offsets)
+{
+    std::uint64_t offset = CAPTURE_HEADER_SIZE;
+    for (int column = 0; column < CC_COLUMN_COUNT; column++)
+    {
+        offsets[column] = offset;
+        offset += capacity * COLUMN_WIDTHS[column];
+        offset = (offset + COLUMN_ALIGNMENT - 1) / COLUMN_ALIGNMENT * COLUMN_ALIGNMENT;
+    }
+    return offset;
+}
+
+CaptureWriter::~CaptureWriter()
+{
+    Close();
+}
+
+bool CaptureWriter::Open(const std::string& filename,
+                         Instrument instrument,
+                         RecordType type,
+                         std::uint64_t initialCapacity)
+{
+    Close();
+
+    mFilename = filename;
+    if (!std::ofstream(filename, std::ios::binary | std::ios::trunc))
+    {
+        return false;
+    }
+
+    std::uint64_t offsets[CC_COLUMN_COUNT];
+    if (!Map(Layout(initialCapacity, offsets)))
+    {
+        return false;
+    }
+
+    std::memcpy(mHeader->magic, CAPTURE_MAGIC, sizeof(mHeader->magic));
+    mHeader->version = CAPTURE_VERSION;
+    mHeader->headerSize = CAPTURE_HEADER_SIZE;
+    mHeader->instrument = static_cast<std::uint8_t>(instrument);
+    mHeader->type = static_cast<std::uint8_t>(type);
+    mHeader->levelCount = TOP_LEVEL_COUNT;
+    mHeader->capacity = initialCapacity;
+    mHeader->rowCount = 0;
+    std::memcpy(mHeader->columnOffsets, offsets, sizeof(offsets));
+    return true;
+}
+
+bool CaptureWriter::Map(std::uint64_t size)
+{
+    mRegion = bip::mapped_region();
+    mHeader = nullptr;
+    try
+    {
+        std::filesystem::resize_file(mFilename, size);
+        bip::file_mapping file(mFilename.c_str(), bip::read_write);
+        mRegion = bip::mapped_region(file, bip::read_write, 0, size);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    mHeader = static_cast<CaptureHeader*>(mRegion.get_address());
+    return true;
+}
+
+void CaptureWriter::Relayout(std::uint64_t capacity)
+{
+    std::uint64_t rows = mHeader->rowCount;
+    std::uint64_t oldOffsets[CC_COLUMN_COUNT];
+    std::uint64_t newOffsets[CC_COLUMN_COUNT];
+    std::memcpy(oldOffsets, mHeader->columnOffsets, sizeof(oldOffsets));
+    std::uint64_t newSize = Layout(capacity, newOffsets);
+    bool growing = capacity > mHeader->capacity;
+
+    // Columns only ever move towards the end of the file when growing and
+    // towards the start when shrinking, so moving them in that order never
+    // overwrites a column that has not been moved yet.
+    if (growing && !Map(newSize))
+    {
+        return;
+    }
+    char* base = static_cast<char*>(mRegion.get_address());
+    for (int i = 0; i < CC_COLUMN_COUNT; i++)
+    {
+        int column = growing ? CC_COLUMN_COUNT - 1 - i : i;
+        std::memmove(base + newOffsets[column], base + oldOffsets[column],
+                     rows * COLUMN_WIDTHS[column]);
+    }
+    std::memcpy(mHeader->columnOffsets, newOffsets, sizeof(newOffsets));
+    mHeader->capacity = capacity;
+    if (!growing)
+    {
+        Map(newSize);
+    }
+}
+
+void CaptureWriter::Append(const MarketRecord& record)
+{
+    if (mHeader == nullptr)
+    {
+        return;
+    }
+    if (mHeader->rowCount == mHeader->capacity)
+    {
+        Relayout(2 * mHeader->capacity);
+        if (mHeader == nullptr || mHeader->rowCount == mHeader->capacity)
+        {
+            return;
+        }
+    }
+
+    std::uint64_t row = mHeader->rowCount;
+    Column<std::uint64_t>(CC_TIMESTAMP)[row] = record.timestamp;
+    Column<unsigned long>(CC_SEQUENCE_NUMBER)[row] = record.sequenceNumber;
+    Column<CaptureLevels>(CC_ASK_PRICES)[row] = record.askPrices;
+    Column<CaptureLevels>(CC_ASK_VOLUMES)[row] = record.askVolumes;
+    Column<CaptureLevels>(CC_BID_PRICES)[row] = record.bidPrices;
+    Column<CaptureLevels>(CC_BID_VOLUMES)[row] = record.bidVolumes;
+    mHeader->rowCount = row + 1;
+}
+
+void CaptureWriter::Close()
+{
+    if (mHeader == nullptr)
+    {
+        return;
+    }
+    Relayout(mHeader->rowCount);
+    if (mHeader != nullptr)
+    {
+        mRegion.flush();
+    }
+    mRegion = bip::mapped_region();
+    mHeader = nullptr;
+}
+
+CaptureReader::CaptureReader(const std::string& filename)
+{
+    try
+    {
+        bip::file_mapping file(filename.c_str(), bip::read_only);
+        mRegion = bip::mapped_region(file, bip::read_only);
+    }
+    catch (const std::exception& e)
+    {
+        throw std::runtime_error("could not map capture " + filename + ": " + e.what());
+    }
+
+    if (mRegion.get_size() < CAPTURE_HEADER_SIZE)
+    {
+        throw std::runtime_error(filename + " is too short to be a capture");
+    }
+    mHeader = static_cast<const CaptureHeader*>(mRegion.get_address());
+    if (std::memcmp(mHeader->magic, CAPTURE_MAGIC, sizeof(mHeader->magic)) != 0
+        || mHeader->version != CAPTURE_VERSION)
+    {
+        throw std::runtime_error(filename + " is not a capture file this build understands");
+    }
+    if (mHeader->levelCount != TOP_LEVEL_COUNT)
+    {
+        throw std::runtime_error(filename + " was captured with a different TOP_LEVEL_COUNT");
+    }
+
+    std::uint64_t offsets[CC_COLUMN_COUNT];
+    if (mHeader->rowCount > mHeader->capacity
+        || Layout(mHeader->capacity, offsets) > mRegion.get_size()
+        || std::memcmp(offsets, mHeader->columnOffsets, sizeof(offsets)) != 0)
+    {
+        throw std::runtime_error(filename + " is truncated or corrupt");
+    }
+}
@@ -0,0 +1,167 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_CAPTURE_H
+#define CPPREADY_TRADER_GO_CAPTURE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/types.h>
+
+#include "recorder.h"
+
+// Columnar capture files.
+//
+// A capture holds the messages of one type for one instrument. It starts with
+// a fixed header followed by one contiguous column per field, so a reader can
+// map the file and use the columns in place. The order book columns hold
+// std::array values of exactly the type the AutoTrader handlers take.
+
+using CaptureLevels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+enum CaptureColumn
+{
+    CC_TIMESTAMP = 0,
+    CC_SEQUENCE_NUMBER,
+    CC_ASK_PRICES,
+    CC_ASK_VOLUMES,
+    CC_BID_PRICES,
+    CC_BID_VOLUMES,
+    CC_COLUMN_COUNT
+};
+
+struct CaptureHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint8_t instrument;      // ReadyTraderGo::Instrument
+    std::uint8_t type;            // RecordType
+    std::uint16_t levelCount;     // ReadyTraderGo::TOP_LEVEL_COUNT when written
+    std::uint32_t reserved;
+    std::uint64_t capacity;       // rows each column has room for
+    std::uint64_t rowCount;       // rows actually written
+    std::uint64_t columnOffsets[CC_COLUMN_COUNT];
+};
+
+constexpr char CAPTURE_MAGIC[8] = {'R', 'T', 'G', 'C', 'A', 'P', 'T', '\0'};
+constexpr std::uint32_t CAPTURE_VERSION = 1;
+
+// The header is padded to a page so that every column starts page aligned.
+constexpr std::size_t CAPTURE_HEADER_SIZE = 4096;
+
+// Appends rows to a capture file through a writable mapping.
+//
+// Room is reserved for a number of rows up front and doubled whenever it runs
+// out; Close() packs the columns together and trims the file. This is meant
+// to be driven from the recorder's writer thread, never from a handler.
+class CaptureWriter
+{
+public:
+    static constexpr std::uint64_t INITIAL_CAPACITY = 1 << 16;
+
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    CaptureWriter(const CaptureWriter&) = delete;
+    CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+    bool IsOpen() const { return mHeader != nullptr; }
+
+    // Create (or overwrite) the file. Returns false if it cannot be mapped.
+    bool Open(const std::string& filename,
+              ReadyTraderGo::Instrument instrument,
+              RecordType type,
+              std::uint64_t initialCapacity = INITIAL_CAPACITY);
+    void Append(const MarketRecord& record);
+    void Close();
+
+private:
+    bool Map(std::uint64_t size);
+    void Relayout(std::uint64_t capacity);
+
+    template<typename T>
+    T* Column(CaptureColumn column)
+    {
+        return reinterpret_cast<T*>(static_cast<char*>(mRegion.get_address())
+                                    + mHeader->columnOffsets[column]);
+    }
+
+    std::string mFilename;
+    boost::interprocess::mapped_region mRegion;
+    CaptureHeader* mHeader = nullptr;
+};
+
+// One row of a capture, referring straight into the mapped file.
+struct CaptureRow
+{
+    std::uint64_t timestamp;
+    unsigned long sequenceNumber;
+    const CaptureLevels& askPrices;
+    const CaptureLevels& askVolumes;
+    const CaptureLevels& bidPrices;
+    const CaptureLevels& bidVolumes;
+};
+
+// Read-only, zero-copy access to a finished capture file.
+//
+// Throws std::runtime_error if the file cannot be mapped or was not written
+// with this build's TOP_LEVEL_COUNT.
+class CaptureReader
+{
+public:
+    explicit CaptureReader(const std::string& filename);
+
+    ReadyTraderGo::Instrument GetInstrument() const
+    {
+        return static_cast<ReadyTraderGo::Instrument>(mHeader->instrument);
+    }
+    RecordType GetType() const { return static_cast<RecordType>(mHeader->type); }
+    std::size_t Size() const { return mHeader->rowCount; }
+
+    const std::uint64_t* Timestamps() const { return Column<std::uint64_t>(CC_TIMESTAMP); }
+    const unsigned long* SequenceNumbers() const { return Column<unsigned long>(CC_SEQUENCE_NUMBER); }
+    const CaptureLevels* AskPrices() const { return Column<CaptureLevels>(CC_ASK_PRICES); }
+    const CaptureLevels* AskVolumes() const { return Column<CaptureLevels>(CC_ASK_VOLUMES); }
+    const CaptureLevels* BidPrices() const { return Column<CaptureLevels>(CC_BID_PRICES); }
+    const CaptureLevels* BidVolumes() const { return Column<CaptureLevels>(CC_BID_VOLUMES); }
+
+    CaptureRow Row(std::size_t i) const
+    {
+        return {Timestamps()[i], SequenceNumbers()[i], AskPrices()[i],
+                AskVolumes()[i], BidPrices()[i], BidVolumes()[i]};
+    }
+
+private:
+    template<typename T>
+    const T* Column(CaptureColumn column) const
+    {
+        return reinterpret_cast<const T*>(static_cast<const char*>(mRegion.get_address())
+                                          + mHeader->columnOffsets[column]);
+    }
+
+    boost::interprocess::mapped_region mRegion;
+    const CaptureHeader* mHeader = nullptr;
+};
+
+#endif //CPPREADY_TRADER_GO_CAPTURE_H
@@ -0,0 +1,308 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include "eventrecorder.h"
+
+using namespace ReadyTraderGo;
+namespace bip = boost::interprocess;
+
+// How long the writer sleeps when it finds the ring empty.
+constexpr std::chrono::milliseconds EVENT_WRITER_IDLE_SLEEP{1};
+
+static std::uint64_t SteadyNanoseconds()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+const char* EventTypeName(EventType type)
+{
+    switch (type)
+    {
+    case EventType::ORDER_BOOK:
+        return "order book";
+    case EventType::TRADE_TICKS:
+        return "trade ticks";
+    case EventType::ORDER_STATUS:
+        return "order status";
+    case EventType::ORDER_FILLED:
+        return "order filled";
+    case EventType::HEDGE_FILLED:
+        return "hedge filled";
+    case EventType::ERROR:
+        return "error";
+    case EventType::DISCONNECT:
+        return "disconnect";
+    case EventType::COUNT:
+        break;
+    }
+    return "unknown";
+}
+
+EventRecorder::EventRecorder(const std::string& filename)
+    : mRing(std::make_unique<SpscRing<EventRecord, RING_CAPACITY>>())
+{
+    // A crash can leave the last record cut short. Cut it off, so that what
+    // this run appends lines up with the records before it; a file too
+    // short for a header is started again.
+    std::error_code error;
+    std::uintmax_t existing = std::filesystem::file_size(filename, error);
+    if (!error && existing != 0)
+    {
+        std::uintmax_t whole = 0;
+        if (existing >= sizeof(RecordFileHeader))
+        {
+            whole = existing - (existing - sizeof(RecordFileHeader)) % sizeof(EventRecord);
+        }
+        if (whole != existing)
+        {
+            std::filesystem::resize_file(filename, whole, error);
+        }
+    }
+
+    mFile = std::fopen(filename.c_str(), "ab");
+    if (mFile == nullptr)
+    {
+        return;
+    }
+
+    // Only a new file gets a header; a restarted bot carries on after the
+    // events already there.
+    std::fseek(mFile, 0, SEEK_END);
+    if (std::ftell(mFile) == 0)
+    {
+        RecordFileHeader header{};
+        std::memcpy(header.magic, EVENT_FILE_MAGIC, sizeof(header.magic));
+        header.version = EVENT_FILE_VERSION;
+        header.recordSize = sizeof(EventRecord);
+        std::fwrite(&header, sizeof(header), 1, mFile);
+    }
+
+    mRunning.store(true, std::memory_order_relaxed);
+    mWriter = std::thread(&EventRecorder::WriterLoop, this);
+}
+
+EventRecorder::~EventRecorder()
+{
+    Close();
+}
+
+void EventRecorder::Close()
+{
+    if (mWriter.joinable())
+    {
+        mRunning.store(false, std::memory_order_release);
+        mWriter.join();
+    }
+    if (mFile != nullptr)
+    {
+        std::fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+EventRecord EventRecorder::Begin(EventType type, unsigned long id)
+{
+    EventRecord record{};
+    record.sequence = ++mSequence;
+    record.received = SteadyNanoseconds();
+    record.type = static_cast<std::uint8_t>(type);
+    record.id = id;
+    return record;
+}
+
+void EventRecorder::Push(const EventRecord& record)
+{
+    if (!mRing->TryPush(record))
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void EventRecorder::RecordMarket(EventType type,
+                                 Instrument instrument,
+                                 unsigned long sequenceNumber,
+                                 const EventRecord::Levels& askPrices,
+                                 const EventRecord::Levels& askVolumes,
+                                 const EventRecord::Levels& bidPrices,
+                                 const EventRecord::Levels& bidVolumes)
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    EventRecord record = Begin(type, sequenceNumber);
+    record.instrument = static_cast<std::uint8_t>(instrument);
+    record.levels[0] = askPrices;
+    record.levels[1] = askVolumes;
+    record.levels[2] = bidPrices;
+    record.levels[3] = bidVolumes;
+    Push(record);
+}
+
+void EventRecorder::RecordOrderBook(Instrument instrument,
+                                    unsigned long sequenceNumber,
+                                    const EventRecord::Levels& askPrices,
+                                    const EventRecord::Levels& askVolumes,
+                                    const EventRecord::Levels& bidPrices,
+                                    const EventRecord::Levels& bidVolumes)
+{
+    RecordMarket(EventType::ORDER_BOOK, instrument, sequenceNumber, askPrices, askVolumes, bidPrices,
+                 bidVolumes);
+}
+
+void EventRecorder::RecordTradeTicks(Instrument instrument,
+                                     unsigned long sequenceNumber,
+                                     const EventRecord::Levels& askPrices,
+                                     const EventRecord::Levels& askVolumes,
+                                     const EventRecord::Levels& bidPrices,
+                                     const EventRecord::Levels& bidVolumes)
+{
+    RecordMarket(EventType::TRADE_TICKS, instrument, sequenceNumber, askPrices, askVolumes, bidPrices,
+                 bidVolumes);
+}
+
+void EventRecorder::RecordOrderStatus(unsigned long clientOrderId,
+                                      unsigned long fillVolume,
+                                      unsigned long remainingVolume,
+                                      signed long fees)
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    EventRecord record = Begin(EventType::ORDER_STATUS, clientOrderId);
+    record.values[0] = static_cast<std::int64_t>(fillVolume);
+    record.values[1] = static_cast<std::int64_t>(remainingVolume);
+    record.values[2] = fees;
+    Push(record);
+}
+
+void EventRecorder::RecordOrderFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume)
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    EventRecord record = Begin(EventType::ORDER_FILLED, clientOrderId);
+    record.values[0] = static_cast<std::int64_t>(price);
+    record.values[1] = static_cast<std::int64_t>(volume);
+    Push(record);
+}
+
+void EventRecorder::RecordHedgeFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume)
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    EventRecord record = Begin(EventType::HEDGE_FILLED, clientOrderId);
+    record.values[0] = static_cast<std::int64_t>(price);
+    record.values[1] = static_cast<std::int64_t>(volume);
+    Push(record);
+}
+
+void EventRecorder::RecordError(unsigned long clientOrderId, const std::string& errorMessage)
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    EventRecord record = Begin(EventType::ERROR, clientOrderId);
+    std::size_t length = std::min(errorMessage.size(), EventRecord::MESSAGE_SIZE - 1);
+    std::memcpy(record.message, errorMessage.data(), length);
+    record.message[length] = '\0';
+    Push(record);
+}
+
+void EventRecorder::RecordDisconnect()
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    Push(Begin(EventType::DISCONNECT, 0));
+}
+
+std::size_t EventRecorder::Drain()
+{
+    std::size_t total = 0;
+    const EventRecord* records;
+    while (std::size_t count = mRing->Peek(&records))
+    {
+        std::fwrite(records, sizeof(EventRecord), count, mFile);
+        mRing->Release(count);
+        total += count;
+    }
+    // Hand each batch to the kernel straight away, so that a crash only
+    // loses what was still in the ring.
+    if (total != 0)
+    {
+        std::fflush(mFile);
+    }
+    return total;
+}
+
+void EventRecorder::WriterLoop()
+{
+    while (mRunning.load(std::memory_order_acquire))
+    {
+        if (Drain() == 0)
+        {
+            std::this_thread::sleep_for(EVENT_WRITER_IDLE_SLEEP);
+        }
+    }
+    Drain();
+}
+
+EventReader::EventReader(const std::string& filename)
+{
+    try
+    {
+        bip::file_mapping file(filename.c_str(), bip::read_only);
+        mRegion = bip::mapped_region(file, bip::read_only);
+    }
+    catch (const std::exception& e)
+    {
+        throw std::runtime_error("could not map event file " + filename + ": " + e.what());
+    }
+
+    if (mRegion.get_size() < sizeof(RecordFileHeader))
+    {
+        throw std::runtime_error(filename + " is too short to be an event file");
+    }
+    const auto* base = static_cast<const char*>(mRegion.get_address());
+    const auto* header = reinterpret_cast<const RecordFileHeader*>(base);
+    if (std::memcmp(header->magic, EVENT_FILE_MAGIC, sizeof(header->magic)) != 0
+        || header->version != EVENT_FILE_VERSION
+        || header->recordSize != sizeof(EventRecord))
+    {
+        throw std::runtime_error(filename + " is not an event file this build understands");
+    }
+
+    mEvents = reinterpret_cast<const EventRecord*>(base + sizeof(RecordFileHeader));
+    mCount = (mRegion.get_size() - sizeof(RecordFileHeader)) / sizeof(EventRecord);
+}
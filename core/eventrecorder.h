@@ -0,0 +1,185 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_EVENTRECORDER_H
+#define CPPREADY_TRADER_GO_EVENTRECORDER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/types.h>
+
+#include "recorder.h"
+#include "spscring.h"
+
+// Where the bots record every callback they receive.
+constexpr char EVENT_LOG_FILENAME[] = "events.evt";
+
+// The callbacks an autotrader receives, in the order of the handlers
+// of BaseAutoTrader.
+enum class EventType : std::uint8_t
+{
+    ORDER_BOOK = 0,
+    TRADE_TICKS = 1,
+    ORDER_STATUS = 2,
+    ORDER_FILLED = 3,
+    HEDGE_FILLED = 4,
+    ERROR = 5,
+    DISCONNECT = 6,
+    COUNT
+};
+
+const char* EventTypeName(EventType type);
+
+// One callback and its arguments. Written to disk as raw memory, so this
+// must stay a fixed-size POD.
+struct EventRecord
+{
+    using Levels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+    static constexpr std::size_t MESSAGE_SIZE = 4 * sizeof(Levels);
+
+    std::uint64_t sequence;       // from one, in the order received
+    std::uint64_t received;       // steady_clock nanoseconds, as ExchangeClockNow()
+    std::uint8_t type;            // EventType
+    std::uint8_t instrument;      // ReadyTraderGo::Instrument, for market data
+    std::uint8_t reserved[6];
+    std::uint64_t id;             // sequence number for market data, else client order id
+    // Order status: fill volume, remaining volume and fees. Order and hedge
+    // fills: price and volume.
+    std::int64_t values[3];
+    union
+    {
+        // Ask prices, ask volumes, bid prices and bid volumes.
+        Levels levels[4];
+        // An error message, truncated and NUL-terminated.
+        char message[MESSAGE_SIZE];
+    };
+};
+
+static_assert(std::is_trivially_copyable<EventRecord>::value, "EventRecord must be POD");
+
+constexpr char EVENT_FILE_MAGIC[8] = {'R', 'T', 'G', 'E', 'V', 'N', 'T', '\0'};
+constexpr std::uint32_t EVENT_FILE_VERSION = 1;
+
+// Records every callback an autotrader receives, in order, to one binary
+// file (a RecordFileHeader and then EventRecords) without blocking the
+// caller.
+//
+// Like the Recorder, each Record* call stamps the event, copies it into a
+// lock-free ring and returns, and a background thread does the file I/O;
+// events are dropped, and counted, if the ring fills up. All Record* calls
+// must come from one thread. Each batch the thread writes is flushed, so a
+// crash loses only the events still in the ring. The file is appended to,
+// so a restarted bot adds to the events of the run before it, with the
+// sequence starting again from one; a record left cut short by a crash is
+// removed first.
+class EventRecorder
+{
+public:
+    static constexpr std::size_t RING_CAPACITY = 1 << 14;
+
+    explicit EventRecorder(const std::string& filename);
+    ~EventRecorder();
+
+    EventRecorder(const EventRecorder&) = delete;
+    EventRecorder& operator=(const EventRecorder&) = delete;
+
+    // Whether the file could be opened.
+    bool IsOpen() const { return mFile != nullptr; }
+
+    // Stop the writer thread, flush everything still queued and close the file.
+    void Close();
+
+    // Number of events dropped because the ring was full.
+    unsigned long Dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+    void RecordOrderBook(ReadyTraderGo::Instrument instrument,
+                         unsigned long sequenceNumber,
+                         const EventRecord::Levels& askPrices,
+                         const EventRecord::Levels& askVolumes,
+                         const EventRecord::Levels& bidPrices,
+                         const EventRecord::Levels& bidVolumes);
+    void RecordTradeTicks(ReadyTraderGo::Instrument instrument,
+                          unsigned long sequenceNumber,
+                          const EventRecord::Levels& askPrices,
+                          const EventRecord::Levels& askVolumes,
+                          const EventRecord::Levels& bidPrices,
+                          const EventRecord::Levels& bidVolumes);
+    void RecordOrderStatus(unsigned long clientOrderId,
+                           unsigned long fillVolume,
+                           unsigned long remainingVolume,
+                           signed long fees);
+    void RecordOrderFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume);
+    void RecordHedgeFilled(unsigned long clientOrderId, unsigned long price, unsigned long volume);
+    void RecordError(unsigned long clientOrderId, const std::string& errorMessage);
+    void RecordDisconnect();
+
+private:
+    EventRecord Begin(EventType type, unsigned long id);
+    void RecordMarket(EventType type,
+                      ReadyTraderGo::Instrument instrument,
+                      unsigned long sequenceNumber,
+                      const EventRecord::Levels& askPrices,
+                      const EventRecord::Levels& askVolumes,
+                      const EventRecord::Levels& bidPrices,
+                      const EventRecord::Levels& bidVolumes);
+    void Push(const EventRecord& record);
+
+    // Write out everything currently in the ring. Returns the event count.
+    std::size_t Drain();
+    void WriterLoop();
+
+    std::unique_ptr<SpscRing<EventRecord, RING_CAPACITY>> mRing;
+    std::uint64_t mSequence = 0;
+    std::FILE* mFile = nullptr;
+    std::thread mWriter;
+    std::atomic<bool> mRunning{false};
+    std::atomic<unsigned long> mDropped{0};
+};
+
+// The events of an event file, mapped read-only. A partly written event at
+// the end, from a bot that was killed, is ignored.
+class EventReader
+{
+public:
+    // Throws std::runtime_error if the file cannot be mapped or is not an
+    // event file this build understands.
+    explicit EventReader(const std::string& filename);
+
+    std::size_t Size() const { return mCount; }
+    const EventRecord& operator[](std::size_t i) const { return mEvents[i]; }
+    const EventRecord* begin() const { return mEvents; }
+    const EventRecord* end() const { return mEvents + mCount; }
+
+private:
+    boost::interprocess::mapped_region mRegion;
+    const EventRecord* mEvents = nullptr;
+    std::size_t mCount = 0;
+};
+
+#endif //CPPREADY_TRADER_GO_EVENTRECORDER_H
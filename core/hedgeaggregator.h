@@ -0,0 +1,137 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_HEDGEAGGREGATOR_H
+#define CPPREADY_TRADER_GO_HEDGEAGGREGATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Nets ETF fills into as few hedge orders as possible.
+//
+// Fills only mark the position as unhedged. Once the netting window has
+// passed, a single hedge is sent for whatever the ETF position, the futures
+// already held and the hedges still in flight leave uncovered, so fills on
+// opposite sides within the window cancel out instead of being hedged twice.
+// Hedges in flight are tracked by id until their HedgeFilled message
+// arrives; any volume they did not fill becomes part of the next residual.
+class HedgeAggregator {
+    static constexpr std::size_t MAX_OUTSTANDING = 16;
+
+public:
+    // Fills are netted for window nanoseconds after the first unhedged one.
+    explicit HedgeAggregator(std::uint64_t window) : mWindow(window) {}
+
+    // Note that the position may no longer be hedged as of now.
+    void Unhedged(std::uint64_t now) {
+        if (!mPending) {
+            mPending = true;
+            mSince = now;
+        }
+    }
+
+    bool Pending() const { return mPending; }
+
+    // When the current netting window closes.
+    std::uint64_t Deadline() const { return mSince + mWindow; }
+
+    bool Due(std::uint64_t now) const { return mPending && now >= Deadline(); }
+
+    // Futures to buy (positive) or sell (negative) to hedge the ETF
+    // position.
+    long Residual(long etfPosition) const {
+        long covered = mFuturePosition;
+        for (std::size_t i = 0; i < mOutstandingCount; i++) {
+            covered += mOutstanding[i].volume;
+        }
+        return -etfPosition - covered;
+    }
+
+    // Record a hedge of volume futures (signed as for Residual) sent under
+    // the given id, which ends the netting window. The reference is the
+    // best future price on the side it trades against when it was sent, or
+    // zero if there was none. Returns false, and records nothing, if too
+    // many hedges are already in flight.
+    bool Sent(unsigned long id, long volume, unsigned long reference) {
+        if (mOutstandingCount == MAX_OUTSTANDING) {
+            return false;
+        }
+        mOutstanding[mOutstandingCount++] = {id, volume, reference};
+        mPending = false;
+        return true;
+    }
+
+    // Nothing is left to hedge.
+    void Hedged() { mPending = false; }
+
+    // Reconcile the HedgeFilled message for a hedge, which is its last,
+    // given the average price it filled at. Returns false if the id is not a
+    // hedge in flight.
+    bool Filled(unsigned long id, unsigned long price, unsigned long volume) {
+        for (std::size_t i = 0; i < mOutstandingCount; i++) {
+            if (mOutstanding[i].id == id) {
+                const Hedge &hedge = mOutstanding[i];
+                long filled = static_cast<long>(volume);
+                long sign = (hedge.volume < 0) ? -1 : 1;
+                mFuturePosition += sign * filled;
+                if (hedge.reference != 0 && filled != 0) {
+                    mSlippage += sign *
+                                 (static_cast<long>(price) -
+                                  static_cast<long>(hedge.reference)) *
+                                 filled;
+                }
+                mOutstanding[i] = mOutstanding[--mOutstandingCount];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Start from a futures position held by an earlier run, with no hedges
+    // in flight and nothing pending.
+    void Restore(long futurePosition) {
+        mFuturePosition = futurePosition;
+        mOutstandingCount = 0;
+        mPending = false;
+    }
+
+    long FuturePosition() const { return mFuturePosition; }
+    std::size_t Outstanding() const { return mOutstandingCount; }
+
+    // Cents paid on filled hedges beyond their reference prices, net of any
+    // price improvement.
+    long Slippage() const { return mSlippage; }
+
+private:
+    struct Hedge {
+        unsigned long id;
+        long volume;
+        unsigned long reference;
+    };
+
+    std::uint64_t mWindow;
+    std::uint64_t mSince = 0;
+    bool mPending = false;
+
+    long mFuturePosition = 0;
+    long mSlippage = 0;
+    std::array<Hedge, MAX_OUTSTANDING> mOutstanding{};
+    std::size_t mOutstandingCount = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_HEDGEAGGREGATOR_H
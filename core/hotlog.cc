@@ -0,0 +1,174 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/log/core.hpp>
+
+#include "spscring.h"
+
+#include "hotlog.h"
+
+using namespace ReadyTraderGo;
+
+std::ostream &operator<<(std::ostream &os, const HotLogMessage &message) {
+    const HotLogRecord &record = message.record;
+    std::size_t arg = 0;
+    for (const char *p = record.format; *p != '\0'; ++p) {
+        if (p[0] != '{' || p[1] != '}' || arg == record.argCount) {
+            os << *p;
+            continue;
+        }
+        const HotLogRecord::Arg &value = record.args[arg];
+        switch (record.types[arg]) {
+        case HotLogRecord::UNSIGNED:
+            os << value.u;
+            break;
+        case HotLogRecord::SIGNED:
+            os << value.i;
+            break;
+        case HotLogRecord::DOUBLE:
+            os << value.d;
+            break;
+        case HotLogRecord::STRING:
+            os << value.s;
+            break;
+        case HotLogRecord::INSTRUMENT:
+            os << static_cast<Instrument>(value.u);
+            break;
+        case HotLogRecord::SIDE:
+            os << (static_cast<Side>(value.u) == Side::BUY ? "BUY" : "SELL");
+            break;
+        case HotLogRecord::TEXT:
+            os << record.text;
+            break;
+        }
+        ++arg;
+        ++p;
+    }
+    return os;
+}
+
+namespace {
+
+constexpr std::size_t CHANNEL_CAPACITY = 4096;
+constexpr std::chrono::milliseconds FORMATTER_IDLE_SLEEP{1};
+
+struct Channel {
+    SpscRing<HotLogRecord, CHANNEL_CAPACITY> ring;
+};
+
+// Owns one ring per logging thread and the thread that formats them. The
+// rings outlive the threads that fill them, so nothing queued is lost when a
+// thread exits.
+class DeferredLogState {
+public:
+    static DeferredLogState &Instance() {
+        static DeferredLogState state;
+        return state;
+    }
+
+    ~DeferredLogState() {
+        mRunning.store(false, std::memory_order_release);
+        if (mFormatter.joinable()) {
+            mFormatter.join();
+        }
+    }
+
+    Channel *Register() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mChannels.push_back(std::make_unique<Channel>());
+        if (!mFormatter.joinable()) {
+            mRunning.store(true, std::memory_order_relaxed);
+            mFormatter = std::thread(&DeferredLogState::FormatterLoop, this);
+        }
+        return mChannels.back().get();
+    }
+
+    bool AllEmpty() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto &channel : mChannels) {
+            if (!channel->ring.Empty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<unsigned long> dropped{0};
+
+private:
+    // Keep the Boost.Log core alive until the formatter has finished with it.
+    DeferredLogState() : mCore(boost::log::core::get()) {}
+
+    std::size_t Drain() {
+        std::size_t total = 0;
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const auto &channel : mChannels) {
+            const HotLogRecord *records;
+            while (std::size_t count = channel->ring.Peek(&records)) {
+                for (std::size_t i = 0; i < count; i++) {
+                    records[i].emit(records[i]);
+                }
+                channel->ring.Release(count);
+                total += count;
+            }
+        }
+        return total;
+    }
+
+    void FormatterLoop() {
+        while (mRunning.load(std::memory_order_acquire)) {
+            if (Drain() == 0) {
+                std::this_thread::sleep_for(FORMATTER_IDLE_SLEEP);
+            }
+        }
+        Drain();
+    }
+
+    boost::log::core_ptr mCore;
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<Channel>> mChannels;
+    std::thread mFormatter;
+    std::atomic<bool> mRunning{false};
+};
+
+} // namespace
+
+void DeferredLog::Push(const HotLogRecord &record) {
+    thread_local Channel *channel = DeferredLogState::Instance().Register();
+    if (!channel->ring.TryPush(record)) {
+        DeferredLogState::Instance().dropped.fetch_add(
+            1, std::memory_order_relaxed);
+    }
+}
+
+void DeferredLog::Flush() {
+    while (!DeferredLogState::Instance().AllEmpty()) {
+        std::this_thread::sleep_for(FORMATTER_IDLE_SLEEP);
+    }
+}
+
+unsigned long DeferredLog::Dropped() {
+    return DeferredLogState::Instance().dropped.load(
+        std::memory_order_relaxed);
+}
@@ -0,0 +1,200 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_HOTLOG_H
+#define CPPREADY_TRADER_GO_HOTLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#include <ready_trader_go/logging.h>
+#include <ready_trader_go/types.h>
+
+// Logging for the handlers that run on every market event.
+//
+//     HOT_LOG(LG_AT, LogLevel::LL_INFO, "order {} filled for {} lots", id, n);
+//
+// Each "{}" in the format is replaced by the next argument. Arguments may be
+// integers, floating point numbers, Instruments, Sides or string literals;
+// the format itself must be a string literal. At most one argument may be a
+// std::string, which is copied into the record and cut to
+// HOT_LOG_TEXT_LENGTH characters.
+//
+// RTG_HOT_LOG_LEVEL names the lowest LogLevel that is compiled in (LL_INFO
+// if not set) and RTG_HOT_LOG_OFF removes every call. Calls below the
+// threshold are discarded at compile time, arguments and all.
+//
+// Normally a call formats its message and hands it to Boost.Log straight
+// away, just like RLOG. With RTG_DEFERRED_LOG defined the call only copies
+// its arguments into a per-thread ring, and a background thread formats the
+// message and passes it to the same Boost.Log logger. Records are dropped,
+// and counted, if that thread falls behind.
+//
+// Plain RLOG remains the right choice for cold paths and for anything that
+// needs several strings or other non-trivial arguments.
+
+#ifndef RTG_HOT_LOG_LEVEL
+#define RTG_HOT_LOG_LEVEL LL_INFO
+#endif
+
+constexpr bool HotLogEnabled(ReadyTraderGo::LogLevel level) {
+#ifdef RTG_HOT_LOG_OFF
+    return false;
+#else
+    return static_cast<int>(level) >=
+           static_cast<int>(ReadyTraderGo::LogLevel::RTG_HOT_LOG_LEVEL);
+#endif
+}
+
+#define HOT_LOG(lg, sev, ...)                                                  \
+    do {                                                                       \
+        if constexpr (HotLogEnabled(sev)) {                                    \
+            HotLogWrite<lg>(sev, __VA_ARGS__);                                 \
+        }                                                                      \
+    } while (false)
+
+constexpr std::size_t HOT_LOG_MAX_ARGS = 8;
+constexpr std::size_t HOT_LOG_TEXT_LENGTH = 63;
+
+struct HotLogRecord;
+using HotLogEmit = void (*)(const HotLogRecord &record);
+
+// Everything needed to format a message later: the literal format, the
+// arguments by value and the logger to hand the result to.
+struct HotLogRecord {
+    enum ArgType : std::uint8_t {
+        UNSIGNED,
+        SIGNED,
+        DOUBLE,
+        STRING,
+        INSTRUMENT,
+        SIDE,
+        TEXT
+    };
+
+    union Arg {
+        unsigned long u;
+        long i;
+        double d;
+        const char *s;
+    };
+
+    HotLogEmit emit;
+    const char *format;
+    ReadyTraderGo::LogLevel level;
+    std::uint8_t argCount;
+    ArgType types[HOT_LOG_MAX_ARGS];
+    Arg args[HOT_LOG_MAX_ARGS];
+    // The std::string argument, if there is one; NUL terminated.
+    char text[HOT_LOG_TEXT_LENGTH + 1];
+};
+
+static_assert(std::is_trivially_copyable<HotLogRecord>::value,
+              "hot log records are copied as raw memory");
+
+// Streams the formatted message of a record.
+struct HotLogMessage {
+    const HotLogRecord &record;
+};
+std::ostream &operator<<(std::ostream &os, const HotLogMessage &message);
+
+// The deferred-mode queue, shared by every thread that logs.
+class DeferredLog {
+public:
+    // Copy a record into the calling thread's ring.
+    static void Push(const HotLogRecord &record);
+
+    // Block until every record queued so far has been handed to Boost.Log.
+    static void Flush();
+
+    // Records dropped because a ring was full.
+    static unsigned long Dropped();
+};
+
+template <typename Logger> void HotLogEmitTo(const HotLogRecord &record) {
+    RLOG(Logger, record.level) << HotLogMessage{record};
+}
+
+inline void HotLogStore(HotLogRecord &record, std::size_t i,
+                        const char *value) {
+    record.types[i] = HotLogRecord::STRING;
+    record.args[i].s = value;
+}
+
+inline void HotLogStore(HotLogRecord &record, std::size_t i,
+                        const std::string &value) {
+    std::size_t length = std::min(value.size(), HOT_LOG_TEXT_LENGTH);
+    value.copy(record.text, length);
+    record.text[length] = '\0';
+    record.types[i] = HotLogRecord::TEXT;
+}
+
+inline void HotLogStore(HotLogRecord &record, std::size_t i,
+                        ReadyTraderGo::Instrument value) {
+    record.types[i] = HotLogRecord::INSTRUMENT;
+    record.args[i].u = static_cast<unsigned long>(value);
+}
+
+inline void HotLogStore(HotLogRecord &record, std::size_t i,
+                        ReadyTraderGo::Side value) {
+    record.types[i] = HotLogRecord::SIDE;
+    record.args[i].u = static_cast<unsigned long>(value);
+}
+
+template <typename T,
+          typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+inline void HotLogStore(HotLogRecord &record, std::size_t i, T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        record.types[i] = HotLogRecord::DOUBLE;
+        record.args[i].d = value;
+    } else if constexpr (std::is_signed<T>::value) {
+        record.types[i] = HotLogRecord::SIGNED;
+        record.args[i].i = value;
+    } else {
+        record.types[i] = HotLogRecord::UNSIGNED;
+        record.args[i].u = value;
+    }
+}
+
+template <typename Logger, typename... Args>
+inline void HotLogWrite(ReadyTraderGo::LogLevel level, const char *format,
+                        const Args &...args) {
+    static_assert(sizeof...(Args) <= HOT_LOG_MAX_ARGS,
+                  "too many arguments for HOT_LOG");
+    static_assert((0 + ... + std::is_same<Args, std::string>::value) <= 1,
+                  "HOT_LOG takes at most one std::string argument");
+
+    HotLogRecord record;
+    record.emit = &HotLogEmitTo<Logger>;
+    record.format = format;
+    record.level = level;
+    record.argCount = sizeof...(Args);
+    std::size_t i = 0;
+    (HotLogStore(record, i++, args), ...);
+
+#ifdef RTG_DEFERRED_LOG
+    DeferredLog::Push(record);
+#else
+    record.emit(record);
+#endif
+}
+
+#endif // CPPREADY_TRADER_GO_HOTLOG_H
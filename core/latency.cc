@@ -0,0 +1,92 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+
+#include "latency.h"
+
+LatencyTicks LatencyHistogram::BucketTop(std::size_t bucket) {
+    if (bucket < SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    unsigned shift = bucket / SUB_BUCKET_COUNT - 1;
+    LatencyTicks lowest = (SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT)
+                          << shift;
+    return lowest + ((LatencyTicks(1) << shift) - 1);
+}
+
+LatencyTicks LatencyHistogram::Percentile(double fraction) const {
+    if (mCount == 0) {
+        return 0;
+    }
+    auto target = static_cast<std::uint64_t>(std::ceil(fraction * mCount));
+    target = std::clamp<std::uint64_t>(target, 1, mCount);
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; bucket++) {
+        seen += mCounts[bucket];
+        if (seen >= target) {
+            return std::min(BucketTop(bucket), mMax);
+        }
+    }
+    return mMax;
+}
+
+const char *LatencyProbeName(LatencyProbe probe) {
+    switch (probe) {
+    case LatencyProbe::BOOK_TO_ORDER:
+        return "book to order";
+    case LatencyProbe::BOOK_HANDLER:
+        return "order book handler";
+    case LatencyProbe::STATUS_TO_HEDGE:
+        return "status to hedge";
+    case LatencyProbe::STATUS_HANDLER:
+        return "order status handler";
+    case LatencyProbe::TICKS_HANDLER:
+        return "trade ticks handler";
+    case LatencyProbe::REPRICE:
+        return "reprice";
+    case LatencyProbe::STATUS_BATCH:
+        return "status batch";
+    case LatencyProbe::COUNT:
+        break;
+    }
+    return "unknown";
+}
+
+// The counter rate is measured over the lifetime of the monitor, which is
+// far longer than any sample and so calibrates itself better the longer we
+// run.
+double LatencyMonitor::NanosecondsPerTick() const {
+#if defined(__x86_64__) || defined(__i386__)
+    LatencyTicks ticks = LatencyNow() - mStartTicks;
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - mStartTime;
+    return ticks != 0 ? elapsed.count() / ticks : 0.0;
+#else
+    return 1.0;
+#endif
+}
+
+LatencySummary LatencyMonitor::Summary(LatencyProbe probe) const {
+    const LatencyHistogram &histogram =
+        mHistograms[static_cast<std::size_t>(probe)];
+    double scale = NanosecondsPerTick();
+    return {histogram.Count(), histogram.Percentile(0.50) * scale,
+            histogram.Percentile(0.99) * scale,
+            histogram.Percentile(0.999) * scale, histogram.Max() * scale};
+}
@@ -0,0 +1,179 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_LATENCY_H
+#define CPPREADY_TRADER_GO_LATENCY_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Always-on latency measurement for the handlers.
+//
+// Timestamps come from the time stamp counter where there is one and from
+// steady_clock otherwise; histograms hold raw ticks and are only converted
+// to nanoseconds when a summary is taken. Recording a sample is a counter
+// read, a few shifts and an increment into preallocated memory.
+
+using LatencyTicks = std::uint64_t;
+
+inline LatencyTicks LatencyNow() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+// Log-linear histogram in the style of HdrHistogram: every power of two is
+// split into SUB_BUCKET_COUNT equal buckets, so a recorded value is known to
+// within about 3% across the whole 64-bit range.
+class LatencyHistogram {
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr std::size_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr std::size_t BUCKET_COUNT =
+        (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+public:
+    void Record(LatencyTicks value) {
+        ++mCounts[BucketOf(value)];
+        ++mCount;
+        if (value > mMax) {
+            mMax = value;
+        }
+    }
+
+    std::uint64_t Count() const { return mCount; }
+    LatencyTicks Max() const { return mMax; }
+
+    // Smallest value that at least the given fraction of samples do not
+    // exceed, rounded up to the top of its bucket. Zero if nothing has been
+    // recorded.
+    LatencyTicks Percentile(double fraction) const;
+
+    void Reset() {
+        mCounts.fill(0);
+        mCount = 0;
+        mMax = 0;
+    }
+
+private:
+    static std::size_t BucketOf(LatencyTicks value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return value;
+        }
+        unsigned msb = 63 - __builtin_clzll(value);
+        unsigned shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_COUNT +
+               ((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+
+    static LatencyTicks BucketTop(std::size_t bucket);
+
+    std::array<std::uint64_t, BUCKET_COUNT> mCounts{};
+    std::uint64_t mCount = 0;
+    LatencyTicks mMax = 0;
+};
+
+// The stretches of the handlers that we time.
+enum class LatencyProbe : std::size_t {
+    // Futures book received until a SendInsertOrder / SendCancelOrder call
+    // made in response to it returns.
+    BOOK_TO_ORDER,
+    // The whole of OrderBookMessageHandler.
+    BOOK_HANDLER,
+    // Order status received until SendHedgeOrder returns.
+    STATUS_TO_HEDGE,
+    // The whole of OrderStatusMessageHandler.
+    STATUS_HANDLER,
+    // The whole of TradeTicksMessageHandler.
+    TICKS_HANDLER,
+    // One conflated reprice of both sides.
+    REPRICE,
+    // One pass applying the order statuses of a burst.
+    STATUS_BATCH,
+    COUNT
+};
+
+const char *LatencyProbeName(LatencyProbe probe);
+
+struct LatencySummary {
+    std::uint64_t count;
+    double p50;
+    double p99;
+    double p999;
+    double max;
+};
+
+// One histogram per probe, plus what is needed to turn ticks into
+// nanoseconds.
+class LatencyMonitor {
+public:
+    LatencyMonitor()
+        : mStartTicks(LatencyNow()),
+          mStartTime(std::chrono::steady_clock::now()) {}
+
+    void Record(LatencyProbe probe, LatencyTicks start) {
+        mHistograms[static_cast<std::size_t>(probe)].Record(LatencyNow() -
+                                                            start);
+    }
+
+    // Percentiles in nanoseconds of everything recorded for the probe.
+    LatencySummary Summary(LatencyProbe probe) const;
+
+    void Reset() {
+        for (auto &histogram : mHistograms) {
+            histogram.Reset();
+        }
+    }
+
+    // The rate of the counter LatencyNow reads, measured so far.
+    double NanosecondsPerTick() const;
+
+private:
+    std::array<LatencyHistogram, static_cast<std::size_t>(LatencyProbe::COUNT)>
+        mHistograms;
+    LatencyTicks mStartTicks;
+    std::chrono::steady_clock::time_point mStartTime;
+};
+
+// Records the time from its construction to its destruction.
+class LatencyTimer {
+public:
+    LatencyTimer(LatencyMonitor &monitor, LatencyProbe probe)
+        : mMonitor(monitor), mProbe(probe), mStart(LatencyNow()) {}
+    ~LatencyTimer() { mMonitor.Record(mProbe, mStart); }
+
+    LatencyTimer(const LatencyTimer &) = delete;
+    LatencyTimer &operator=(const LatencyTimer &) = delete;
+
+    LatencyTicks Start() const { return mStart; }
+
+private:
+    LatencyMonitor &mMonitor;
+    LatencyProbe mProbe;
+    LatencyTicks mStart;
+};
+
+#endif // CPPREADY_TRADER_GO_LATENCY_H
@@ -0,0 +1,149 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include "marketstate.h"
+
+namespace bip = boost::interprocess;
+
+using namespace ReadyTraderGo;
+
+namespace {
+
+constexpr char MARKET_STATE_MAGIC[8] = "RTGMKST";
+constexpr std::uint32_t MARKET_STATE_VERSION = 1;
+
+// Weight of the newest basis in the running average.
+constexpr double BASIS_SMOOTHING = 0.05;
+
+struct MarketStateFile {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t snapshotSize;
+    alignas(64) Seqlock<MarketSnapshot> state;
+};
+
+unsigned long Total(const BookSnapshot::Levels &volumes) {
+    unsigned long total = 0;
+    for (unsigned long volume : volumes) {
+        total += volume;
+    }
+    return total;
+}
+
+} // namespace
+
+MarketState::MarketState(const std::string &filename) {
+    if (filename.empty()) {
+        return;
+    }
+    try {
+        std::ofstream(filename, std::ios::binary | std::ios::trunc);
+        std::filesystem::resize_file(filename, sizeof(MarketStateFile));
+        bip::file_mapping file(filename.c_str(), bip::read_write);
+        mRegion = bip::mapped_region(file, bip::read_write, 0,
+                                     sizeof(MarketStateFile));
+    } catch (const std::exception &) {
+        return;
+    }
+
+    auto *shared = new (mRegion.get_address()) MarketStateFile{};
+    std::memcpy(shared->magic, MARKET_STATE_MAGIC, sizeof(shared->magic));
+    shared->version = MARKET_STATE_VERSION;
+    shared->snapshotSize = sizeof(MarketSnapshot);
+    mShared = &shared->state;
+}
+
+unsigned MarketState::Update(Instrument instrument,
+                             unsigned long sequenceNumber,
+                             const BookSnapshot::Levels &askPrices,
+                             const BookSnapshot::Levels &askVolumes,
+                             const BookSnapshot::Levels &bidPrices,
+                             const BookSnapshot::Levels &bidVolumes) {
+    auto index = static_cast<std::size_t>(instrument);
+    unsigned changes = mCurrent.books[index].Update(askPrices, askVolumes,
+                                                    bidPrices, bidVolumes);
+    mCurrent.sequenceNumbers[index] = sequenceNumber;
+    if (instrument == Instrument::ETF) {
+        mCurrent.etfAskDepth = Total(askVolumes);
+        mCurrent.etfBidDepth = Total(bidVolumes);
+    }
+    if ((changes & (ASK_BEST | BID_BEST)) != 0) {
+        UpdateBasis();
+    }
+
+    if (mShared != nullptr) {
+        mShared->Store(mCurrent);
+    }
+    return changes;
+}
+
+void MarketState::UpdateBasis() {
+    const BookSnapshot &etf = mCurrent.Book(Instrument::ETF);
+    const BookSnapshot &future = mCurrent.Book(Instrument::FUTURE);
+    if (etf.askPrices[0] == 0 || etf.bidPrices[0] == 0 ||
+        future.askPrices[0] == 0 || future.bidPrices[0] == 0) {
+        return;
+    }
+
+    // Sums of best ask and bid are twice the mids, so no rounding until the
+    // difference is halved.
+    long etfMid2 = static_cast<long>(etf.askPrices[0] + etf.bidPrices[0]);
+    long futureMid2 =
+        static_cast<long>(future.askPrices[0] + future.bidPrices[0]);
+    mCurrent.basis = (etfMid2 - futureMid2) / 2;
+
+    if (!mHaveBasis) {
+        mCurrent.averageBasis = mCurrent.basis;
+        mHaveBasis = true;
+    } else {
+        mCurrent.averageBasis +=
+            BASIS_SMOOTHING * (mCurrent.basis - mCurrent.averageBasis);
+    }
+}
+
+MarketStateReader::MarketStateReader(const std::string &filename) {
+    try {
+        bip::file_mapping file(filename.c_str(), bip::read_only);
+        mRegion = bip::mapped_region(file, bip::read_only);
+    } catch (const std::exception &e) {
+        throw std::runtime_error("could not map market state " + filename +
+                                 ": " + e.what());
+    }
+
+    if (mRegion.get_size() < sizeof(MarketStateFile)) {
+        throw std::runtime_error(filename +
+                                 " is too short to be a market state file");
+    }
+    const auto *shared =
+        static_cast<const MarketStateFile *>(mRegion.get_address());
+    if (std::memcmp(shared->magic, MARKET_STATE_MAGIC, sizeof(shared->magic)) !=
+            0 ||
+        shared->version != MARKET_STATE_VERSION ||
+        shared->snapshotSize != sizeof(MarketSnapshot)) {
+        throw std::runtime_error(
+            filename + " is not a market state file this build understands");
+    }
+    mShared = &shared->state;
+}
@@ -0,0 +1,108 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_MARKETSTATE_H
+#define CPPREADY_TRADER_GO_MARKETSTATE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/types.h>
+
+#include "booksnapshot.h"
+#include "seqlock.h"
+
+// Everything we know about both instruments after the latest book.
+struct MarketSnapshot {
+    // Indexed by Instrument.
+    std::array<BookSnapshot, 2> books;
+    std::array<unsigned long, 2> sequenceNumbers;
+
+    // ETF mid price minus future mid price, in cents, and an exponentially
+    // weighted average of it. Both are zero until each instrument has had a
+    // two-sided book.
+    long basis;
+    double averageBasis;
+
+    // Volume resting over all the reported levels of the ETF book.
+    unsigned long etfAskDepth;
+    unsigned long etfBidDepth;
+
+    const BookSnapshot &Book(ReadyTraderGo::Instrument instrument) const {
+        return books[static_cast<std::size_t>(instrument)];
+    }
+};
+
+// Live market state shared with other processes.
+//
+// The trading thread applies every book with Update() and reads its own
+// copy through Current(), without locks or copies. After each update the
+// snapshot is also published through a seqlock in a memory-mapped file, from
+// which a MarketStateReader in any other process can take consistent copies
+// without ever holding up the writer.
+class MarketState {
+public:
+    // Publishes to the named file, which is created or truncated. With an
+    // empty name, or if the file cannot be mapped, nothing is published.
+    explicit MarketState(const std::string &filename);
+
+    MarketState(const MarketState &) = delete;
+    MarketState &operator=(const MarketState &) = delete;
+
+    // Apply a book and return how it differs from the instrument's last one
+    // (see BookChange).
+    unsigned Update(
+        ReadyTraderGo::Instrument instrument, unsigned long sequenceNumber,
+        const BookSnapshot::Levels &askPrices,
+        const BookSnapshot::Levels &askVolumes,
+        const BookSnapshot::Levels &bidPrices,
+        const BookSnapshot::Levels &bidVolumes);
+
+    const MarketSnapshot &Current() const { return mCurrent; }
+
+    bool Published() const { return mShared != nullptr; }
+
+private:
+    void UpdateBasis();
+
+    MarketSnapshot mCurrent{};
+    bool mHaveBasis = false;
+
+    boost::interprocess::mapped_region mRegion;
+    Seqlock<MarketSnapshot> *mShared = nullptr;
+};
+
+// Read-only view of the state a MarketState publishes.
+class MarketStateReader {
+public:
+    // Throws std::runtime_error if the file is not a market state file.
+    explicit MarketStateReader(const std::string &filename);
+
+    MarketSnapshot Read() const { return mShared->Load(); }
+
+    // Number of updates published so far.
+    std::uint64_t Version() const { return mShared->Version(); }
+
+private:
+    boost::interprocess::mapped_region mRegion;
+    const Seqlock<MarketSnapshot> *mShared = nullptr;
+};
+
+#endif // CPPREADY_TRADER_GO_MARKETSTATE_H
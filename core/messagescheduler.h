@@ -0,0 +1,241 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_MESSAGESCHEDULER_H
+#define CPPREADY_TRADER_GO_MESSAGESCHEDULER_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <ready_trader_go/types.h>
+
+// The exchange's message rate limit and how much of it quoting may use.
+struct MessageBudget {
+    // MessageFrequencyLimit and MessageFrequencyInterval from exchange.json.
+    unsigned long limit = 50;
+    std::uint64_t interval = 1000000000; // nanoseconds
+
+    // Messages kept back for hedges, which are never held up.
+    unsigned long hedgeReserve = 5;
+
+    // Further messages that must be spare before an optional cancel is sent.
+    unsigned long spareReserve = 10;
+};
+
+// One order message the strategy would like to send.
+struct OrderIntent {
+    enum Kind : std::uint8_t { CANCEL, INSERT, AMEND };
+
+    // How much the intent matters when there are not enough messages left
+    // for all of them.
+    enum Urgency : std::uint8_t {
+        // Cancel an order the market has moved through.
+        STALE,
+        // Insert an order at the new quote, or shrink the one already there.
+        QUOTE,
+        // Cancel an order that is merely resting away from our quotes.
+        SPARE
+    };
+
+    Kind kind;
+    Urgency urgency;
+    ReadyTraderGo::Side side;
+    unsigned long orderId; // for cancels and amends
+    unsigned long price;
+    unsigned long volume; // for inserts; the new total volume for amends
+};
+
+// Sits between the strategy and the Send* calls and keeps order messages
+// within the exchange's sliding-window rate limit.
+//
+// For each book the strategy stages what it would like to send between
+// Begin() and Flush(). Flush() then sends the most useful intents that fit
+// in the budget: stale cancels first, then inserts, then optional cancels,
+// alternating between the sides at each level. Whatever does not fit is
+// dropped rather than queued, because the next book will stage fresh
+// intents that supersede it. A cancel and an insert at the same price on the
+// same side would leave the book as it is, so both are dropped unsent.
+class MessageScheduler {
+    // Sends the window can remember; larger limits are clamped to this.
+    static constexpr std::size_t MAX_LIMIT = 64;
+    // Enough for every order on both sides plus an insert and a spare
+    // cancel on each.
+    static constexpr std::size_t MAX_INTENTS = 32;
+
+public:
+    explicit MessageScheduler(const MessageBudget &budget = MessageBudget())
+        : mBudget(budget) {
+        mBudget.limit = std::min<unsigned long>(mBudget.limit, MAX_LIMIT);
+    }
+
+    // Start staging intents for a book that arrived at the given time.
+    void Begin(std::uint64_t now) {
+        mNow = now;
+        mIntentCount = 0;
+        mRanks.fill(0);
+    }
+
+    void Cancel(ReadyTraderGo::Side side, unsigned long orderId,
+                unsigned long price, OrderIntent::Urgency urgency) {
+        Stage({OrderIntent::CANCEL, urgency, side, orderId, price, 0});
+    }
+
+    void Insert(ReadyTraderGo::Side side, unsigned long price,
+                unsigned long volume) {
+        Stage({OrderIntent::INSERT, OrderIntent::QUOTE, side, 0, price,
+               volume});
+    }
+
+    // Reduce the total volume of an order, keeping its queue position.
+    void Amend(ReadyTraderGo::Side side, unsigned long orderId,
+               unsigned long price, unsigned long volume) {
+        Stage({OrderIntent::AMEND, OrderIntent::QUOTE, side, orderId, price,
+               volume});
+    }
+
+    // Calls send(const OrderIntent &) for every staged intent the budget
+    // allows, in the order they should go out, and forgets the rest. Returns
+    // a bit (1 << side) for each side that had intents left unsent.
+    template <typename Send> unsigned Flush(Send &&send) {
+        Coalesce();
+        std::sort(mOrder.begin(), mOrder.begin() + mIntentCount,
+                  [this](std::uint8_t a, std::uint8_t b) {
+                      return Key(a) < Key(b);
+                  });
+
+        Expire(mNow);
+        unsigned deferredSides = 0;
+        for (std::size_t i = 0; i < mIntentCount; i++) {
+            const OrderIntent &intent = mIntents[mOrder[i]];
+            if (intent.kind == DROPPED) {
+                continue;
+            }
+            unsigned long reserve = mBudget.hedgeReserve;
+            if (intent.urgency == OrderIntent::SPARE) {
+                reserve += mBudget.spareReserve;
+            }
+            if (mSentCount + reserve >= mBudget.limit) {
+                mDeferred++;
+                deferredSides |= 1u << static_cast<unsigned>(intent.side);
+                continue;
+            }
+            send(intent);
+            Push(mNow);
+        }
+        mIntentCount = 0;
+        return deferredSides;
+    }
+
+    // Count a message sent outside of Flush, e.g. a hedge.
+    void Count(std::uint64_t now) {
+        Expire(now);
+        Push(now);
+    }
+
+    // Messages sent within the interval ending at the given time.
+    unsigned long SentInWindow(std::uint64_t now) {
+        Expire(now);
+        return mSentCount;
+    }
+
+    // Intents dropped because the budget was spent.
+    unsigned long Deferred() const { return mDeferred; }
+
+private:
+    // Marks coalesced intents; never passed to send.
+    static constexpr OrderIntent::Kind DROPPED =
+        static_cast<OrderIntent::Kind>(0xFF);
+
+    void Stage(const OrderIntent &intent) {
+        if (mIntentCount == MAX_INTENTS) {
+            mDeferred++;
+            return;
+        }
+        std::size_t rank = static_cast<std::size_t>(intent.side) * 3 +
+                           static_cast<std::size_t>(intent.urgency);
+        mIntents[mIntentCount] = intent;
+        mRankOf[mIntentCount] = mRanks[rank]++;
+        mOrder[mIntentCount] = static_cast<std::uint8_t>(mIntentCount);
+        mIntentCount++;
+    }
+
+    // Urgency first, then alternate sides within each urgency.
+    unsigned long Key(std::uint8_t i) const {
+        const OrderIntent &intent = mIntents[i];
+        return (static_cast<unsigned long>(intent.urgency) << 16) |
+               (static_cast<unsigned long>(mRankOf[i]) << 1) |
+               static_cast<unsigned long>(intent.side);
+    }
+
+    void Coalesce() {
+        for (std::size_t i = 0; i < mIntentCount; i++) {
+            OrderIntent &insert = mIntents[i];
+            if (insert.kind != OrderIntent::INSERT) {
+                continue;
+            }
+            for (std::size_t j = 0; j < mIntentCount; j++) {
+                OrderIntent &cancel = mIntents[j];
+                if (cancel.kind == OrderIntent::CANCEL &&
+                    cancel.side == insert.side &&
+                    cancel.price == insert.price) {
+                    cancel.kind = DROPPED;
+                    insert.kind = DROPPED;
+                    break;
+                }
+            }
+        }
+    }
+
+    void Expire(std::uint64_t now) {
+        while (mSentCount != 0 &&
+               mSent[mOldest] + mBudget.interval <= now) {
+            mOldest = (mOldest + 1) % MAX_LIMIT;
+            mSentCount--;
+        }
+    }
+
+    // A send beyond the limit (only hedges can cause one) forgets the
+    // oldest send, which the exchange would already count as a breach.
+    void Push(std::uint64_t now) {
+        if (mSentCount == MAX_LIMIT) {
+            mOldest = (mOldest + 1) % MAX_LIMIT;
+            mSentCount--;
+        }
+        mSent[(mOldest + mSentCount) % MAX_LIMIT] = now;
+        mSentCount++;
+    }
+
+    MessageBudget mBudget;
+    std::uint64_t mNow = 0;
+
+    // Send times within the window, oldest first, as a ring.
+    std::array<std::uint64_t, MAX_LIMIT> mSent{};
+    std::size_t mOldest = 0;
+    std::size_t mSentCount = 0;
+
+    std::array<OrderIntent, MAX_INTENTS> mIntents{};
+    std::array<std::uint8_t, MAX_INTENTS> mRankOf{};
+    std::array<std::uint8_t, MAX_INTENTS> mOrder{};
+    std::array<std::uint8_t, 6> mRanks{};
+    std::size_t mIntentCount = 0;
+
+    unsigned long mDeferred = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_MESSAGESCHEDULER_H
@@ -0,0 +1,149 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#include <boost/interprocess/file_mapping.hpp>
+
+#include "metrics.h"
+
+namespace bip = boost::interprocess;
+
+namespace {
+
+constexpr char METRICS_MAGIC[8] = "RTGMTRC";
+constexpr std::uint32_t METRICS_VERSION = 1;
+
+struct MetricsFile {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t metricCount;
+    std::uint32_t probeCount;
+    alignas(64) MetricsBlock block;
+};
+
+} // namespace
+
+const char *MetricName(Metric metric) {
+    switch (metric) {
+    case Metric::BOOKS:
+        return "books";
+    case Metric::STALE_BOOKS:
+        return "stale books";
+    case Metric::STALE_TICKS:
+        return "stale trade ticks";
+    case Metric::INSERTS:
+        return "inserts";
+    case Metric::AMENDS:
+        return "amends";
+    case Metric::CANCELS:
+        return "cancels";
+    case Metric::HEDGES:
+        return "hedges";
+    case Metric::FILLED_LOTS:
+        return "filled lots";
+    case Metric::HEDGED_LOTS:
+        return "hedged lots";
+    case Metric::ERRORS:
+        return "errors";
+    case Metric::HELD_REQUOTES:
+        return "held requotes";
+    case Metric::DEFERRED_INTENTS:
+        return "deferred intents";
+    case Metric::MESSAGES_IN_WINDOW:
+        return "messages in window";
+    case Metric::MESSAGE_LIMIT:
+        return "message limit";
+    case Metric::POSITION:
+        return "position";
+    case Metric::FUTURE_POSITION:
+        return "future position";
+    case Metric::RESTING_ASKS:
+        return "resting asks";
+    case Metric::RESTING_BIDS:
+        return "resting bids";
+    case Metric::HEDGES_IN_FLIGHT:
+        return "hedges in flight";
+    case Metric::HEDGE_SLIPPAGE:
+        return "hedge slippage";
+    case Metric::COUNT:
+        break;
+    }
+    return "unknown";
+}
+
+bool IsCounter(Metric metric) { return metric < Metric::MESSAGES_IN_WINDOW; }
+
+Metrics::Metrics()
+    : mPrivate(std::make_unique<MetricsBlock>()), mBlock(mPrivate.get()) {}
+
+bool Metrics::PublishTo(const std::string &filename) {
+    try {
+        std::ofstream(filename, std::ios::binary | std::ios::trunc);
+        std::filesystem::resize_file(filename, sizeof(MetricsFile));
+        bip::file_mapping file(filename.c_str(), bip::read_write);
+        mRegion = bip::mapped_region(file, bip::read_write, 0,
+                                     sizeof(MetricsFile));
+    } catch (const std::exception &) {
+        return false;
+    }
+
+    auto *shared = new (mRegion.get_address()) MetricsFile{};
+    std::memcpy(shared->magic, METRICS_MAGIC, sizeof(shared->magic));
+    shared->version = METRICS_VERSION;
+    shared->metricCount = METRIC_COUNT;
+    shared->probeCount = static_cast<std::uint32_t>(LatencyProbe::COUNT);
+    for (std::size_t i = 0; i < METRIC_COUNT; i++) {
+        shared->block.metrics[i].value.store(
+            mBlock->metrics[i].value.load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+    }
+    shared->block.latency.Store(mBlock->latency.Load());
+    mBlock = &shared->block;
+    mPrivate.reset();
+    return true;
+}
+
+MetricsReader::MetricsReader(const std::string &filename) {
+    try {
+        bip::file_mapping file(filename.c_str(), bip::read_only);
+        mRegion = bip::mapped_region(file, bip::read_only);
+    } catch (const std::exception &e) {
+        throw std::runtime_error("could not map metrics " + filename + ": " +
+                                 e.what());
+    }
+
+    if (mRegion.get_size() < sizeof(MetricsFile)) {
+        throw std::runtime_error(filename +
+                                 " is too short to be a metrics file");
+    }
+    const auto *shared =
+        static_cast<const MetricsFile *>(mRegion.get_address());
+    if (std::memcmp(shared->magic, METRICS_MAGIC, sizeof(shared->magic)) !=
+            0 ||
+        shared->version != METRICS_VERSION ||
+        shared->metricCount != METRIC_COUNT ||
+        shared->probeCount != static_cast<std::uint32_t>(LatencyProbe::COUNT)) {
+        throw std::runtime_error(
+            filename + " is not a metrics file this build understands");
+    }
+    mBlock = &shared->block;
+}
@@ -0,0 +1,159 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_METRICS_H
+#define CPPREADY_TRADER_GO_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "latency.h"
+#include "seqlock.h"
+
+// Where the autotrader publishes its metrics for other processes.
+constexpr char METRICS_FILENAME[] = "metrics.dat";
+
+// Everything the autotrader counts or measures while it trades. Counters
+// only ever go up; gauges hold the latest value.
+enum class Metric : std::size_t {
+    // Counters.
+    BOOKS,
+    STALE_BOOKS,
+    STALE_TICKS,
+    INSERTS,
+    AMENDS,
+    CANCELS,
+    HEDGES,
+    FILLED_LOTS,
+    HEDGED_LOTS,
+    ERRORS,
+    HELD_REQUOTES,
+    DEFERRED_INTENTS,
+    // Gauges.
+    MESSAGES_IN_WINDOW,
+    MESSAGE_LIMIT,
+    POSITION,
+    FUTURE_POSITION,
+    RESTING_ASKS,
+    RESTING_BIDS,
+    HEDGES_IN_FLIGHT,
+    // Cents paid on hedges beyond the best future price when each was sent.
+    HEDGE_SLIPPAGE,
+    COUNT
+};
+
+constexpr std::size_t METRIC_COUNT = static_cast<std::size_t>(Metric::COUNT);
+
+const char *MetricName(Metric metric);
+
+bool IsCounter(Metric metric);
+
+using LatencySummaries =
+    std::array<LatencySummary, static_cast<std::size_t>(LatencyProbe::COUNT)>;
+
+// Everything one page of metrics holds. Each metric has a cache line of
+// its own, so a reader polling one never takes the line of another away
+// from the trading thread.
+struct MetricsBlock {
+    struct alignas(64) Slot {
+        std::atomic<std::int64_t> value{0};
+    };
+
+    std::array<Slot, METRIC_COUNT> metrics;
+    Seqlock<LatencySummaries> latency;
+};
+
+// Counters and gauges the trading thread updates as it goes, optionally
+// published to a memory-mapped file for a MetricsReader in another process.
+//
+// Every metric has a single writer, the trading thread, so an update is a
+// relaxed load and store of the metric's own word rather than a locked
+// read-modify-write, and a reader never holds the writer up. Latency
+// summaries change together and are published through a seqlock instead.
+// Until PublishTo() is called the metrics live in private memory.
+class Metrics {
+public:
+    Metrics();
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    // Move the metrics to the named file, which is created or truncated,
+    // carrying over their values so far. Returns false, and keeps them
+    // private, if the file cannot be mapped.
+    bool PublishTo(const std::string &filename);
+
+    bool Published() const { return mRegion.get_address() != nullptr; }
+
+    void Add(Metric metric, std::int64_t amount = 1) {
+        std::atomic<std::int64_t> &value = Slot(metric);
+        value.store(value.load(std::memory_order_relaxed) + amount,
+                    std::memory_order_relaxed);
+    }
+
+    void Set(Metric metric, std::int64_t value) {
+        Slot(metric).store(value, std::memory_order_relaxed);
+    }
+
+    std::int64_t Get(Metric metric) const {
+        return mBlock->metrics[static_cast<std::size_t>(metric)].value.load(
+            std::memory_order_relaxed);
+    }
+
+    void SetLatency(const LatencySummaries &summaries) {
+        mBlock->latency.Store(summaries);
+    }
+
+private:
+    std::atomic<std::int64_t> &Slot(Metric metric) {
+        return mBlock->metrics[static_cast<std::size_t>(metric)].value;
+    }
+
+    std::unique_ptr<MetricsBlock> mPrivate;
+    boost::interprocess::mapped_region mRegion;
+    MetricsBlock *mBlock;
+};
+
+// Read-only view of the metrics a Metrics publishes.
+class MetricsReader {
+public:
+    // Throws std::runtime_error if the file is not a metrics file.
+    explicit MetricsReader(const std::string &filename);
+
+    std::int64_t Get(Metric metric) const {
+        return mBlock->metrics[static_cast<std::size_t>(metric)].value.load(
+            std::memory_order_relaxed);
+    }
+
+    // As of the autotrader's last latency report.
+    LatencySummaries Latency() const { return mBlock->latency.Load(); }
+
+    // Number of latency reports published so far.
+    std::uint64_t LatencyReports() const { return mBlock->latency.Version(); }
+
+private:
+    boost::interprocess::mapped_region mRegion;
+    const MetricsBlock *mBlock = nullptr;
+};
+
+#endif // CPPREADY_TRADER_GO_METRICS_H
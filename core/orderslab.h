@@ -0,0 +1,244 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_ORDERSLAB_H
+#define CPPREADY_TRADER_GO_ORDERSLAB_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+struct Order {
+
+    unsigned long price;
+
+    unsigned long remainingVolume;
+    unsigned long filledVolume;
+
+    bool cancelling = false;
+
+    // Total volume asked for by an amend that has not been confirmed yet, or
+    // zero if there is none.
+    unsigned long amendVolume = 0;
+};
+
+// Fixed-capacity storage for the orders resting on one side of the book.
+//
+// Orders live in a contiguous array, are found by id through a small
+// open-addressed index and are linked into an intrusive list kept sorted from
+// the best price (as decided by Better) to the worst. Nothing allocates, and
+// the best and worst orders are available in constant time.
+template <std::size_t Capacity, typename Better> class OrderSlab {
+    static_assert(Capacity > 0 && Capacity < 0xFF,
+                  "slot indices must fit in a byte");
+
+    using Slot = std::uint8_t;
+    static constexpr Slot NIL = 0xFF;
+
+    static constexpr std::size_t IndexSize() {
+        std::size_t size = 1;
+        while (size < 2 * Capacity)
+            size <<= 1;
+        return size;
+    }
+    static constexpr std::size_t INDEX_SIZE = IndexSize();
+    static constexpr std::size_t INDEX_MASK = INDEX_SIZE - 1;
+
+public:
+    static constexpr std::size_t CAPACITY = Capacity;
+
+    struct Entry {
+        unsigned long id;
+        Order order;
+    };
+
+    // Walks the orders from the best price to the worst.
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Entry *;
+        using reference = Entry &;
+
+        Iterator(OrderSlab *slab, Slot slot) : mSlab(slab), mSlot(slot) {}
+
+        Entry &operator*() const { return mSlab->mEntries[mSlot]; }
+        Entry *operator->() const { return &mSlab->mEntries[mSlot]; }
+        Iterator &operator++() {
+            mSlot = mSlab->mNext[mSlot];
+            return *this;
+        }
+        bool operator==(const Iterator &other) const {
+            return mSlot == other.mSlot;
+        }
+        bool operator!=(const Iterator &other) const {
+            return mSlot != other.mSlot;
+        }
+
+    private:
+        OrderSlab *mSlab;
+        Slot mSlot;
+    };
+
+    OrderSlab() { Clear(); }
+
+    Iterator begin() { return Iterator(this, mHead); }
+    Iterator end() { return Iterator(this, NIL); }
+
+    std::size_t Size() const { return mSize; }
+    bool Empty() const { return mSize == 0; }
+    bool Full() const { return mSize == Capacity; }
+
+    bool Contains(unsigned long id) const { return Lookup(id) != INDEX_SIZE; }
+
+    // Returns the order with the given id or nullptr if we are not tracking it.
+    Order *Find(unsigned long id) {
+        std::size_t i = Lookup(id);
+        return i == INDEX_SIZE ? nullptr : &mEntries[mIndex[i]].order;
+    }
+
+    // The order with the best and worst price respectively, or nullptr.
+    Entry *Best() { return mHead == NIL ? nullptr : &mEntries[mHead]; }
+    Entry *Worst() { return mTail == NIL ? nullptr : &mEntries[mTail]; }
+
+    // Neighbours of an entry in price order, or nullptr at either end.
+    Entry *Next(const Entry &entry) {
+        Slot next = mNext[SlotOf(entry)];
+        return next == NIL ? nullptr : &mEntries[next];
+    }
+    Entry *Prev(const Entry &entry) {
+        Slot prev = mPrev[SlotOf(entry)];
+        return prev == NIL ? nullptr : &mEntries[prev];
+    }
+
+    // Starts tracking an order. Orders at the same price keep their arrival
+    // order. Returns nullptr if the slab is full.
+    Order *Insert(unsigned long id, const Order &order) {
+        if (mFree == NIL) {
+            return nullptr;
+        }
+        Slot slot = mFree;
+        mFree = mNext[slot];
+        mEntries[slot] = {id, order};
+
+        std::size_t i = id & INDEX_MASK;
+        while (mIndex[i] != NIL) {
+            i = (i + 1) & INDEX_MASK;
+        }
+        mIndex[i] = slot;
+
+        Slot after = mTail;
+        while (after != NIL &&
+               Better()(order.price, mEntries[after].order.price)) {
+            after = mPrev[after];
+        }
+        mPrev[slot] = after;
+        mNext[slot] = after == NIL ? mHead : mNext[after];
+        if (mNext[slot] == NIL) {
+            mTail = slot;
+        } else {
+            mPrev[mNext[slot]] = slot;
+        }
+        if (after == NIL) {
+            mHead = slot;
+        } else {
+            mNext[after] = slot;
+        }
+
+        mSize++;
+        return &mEntries[slot].order;
+    }
+
+    // Stops tracking an order. Returns false if the id was unknown.
+    bool Erase(unsigned long id) {
+        std::size_t i = Lookup(id);
+        if (i == INDEX_SIZE) {
+            return false;
+        }
+        Slot slot = mIndex[i];
+
+        // Backward-shift deletion keeps every probe sequence unbroken without
+        // needing tombstones.
+        mIndex[i] = NIL;
+        for (std::size_t j = (i + 1) & INDEX_MASK; mIndex[j] != NIL;
+             j = (j + 1) & INDEX_MASK) {
+            std::size_t home = mEntries[mIndex[j]].id & INDEX_MASK;
+            if (((j - home) & INDEX_MASK) >= ((j - i) & INDEX_MASK)) {
+                mIndex[i] = mIndex[j];
+                mIndex[j] = NIL;
+                i = j;
+            }
+        }
+
+        if (mPrev[slot] == NIL) {
+            mHead = mNext[slot];
+        } else {
+            mNext[mPrev[slot]] = mNext[slot];
+        }
+        if (mNext[slot] == NIL) {
+            mTail = mPrev[slot];
+        } else {
+            mPrev[mNext[slot]] = mPrev[slot];
+        }
+
+        mNext[slot] = mFree;
+        mFree = slot;
+        mSize--;
+        return true;
+    }
+
+    void Clear() {
+        mIndex.fill(NIL);
+        for (std::size_t i = 0; i != Capacity; ++i) {
+            mNext[i] = (i + 1 == Capacity) ? NIL : Slot(i + 1);
+            mPrev[i] = NIL;
+        }
+        mFree = 0;
+        mHead = mTail = NIL;
+        mSize = 0;
+    }
+
+private:
+    Slot SlotOf(const Entry &entry) const {
+        return Slot(&entry - mEntries.data());
+    }
+
+    // Returns the index position holding id, or INDEX_SIZE if absent.
+    std::size_t Lookup(unsigned long id) const {
+        for (std::size_t i = id & INDEX_MASK; mIndex[i] != NIL;
+             i = (i + 1) & INDEX_MASK) {
+            if (mEntries[mIndex[i]].id == id) {
+                return i;
+            }
+        }
+        return INDEX_SIZE;
+    }
+
+    std::array<Entry, Capacity> mEntries{};
+    std::array<Slot, Capacity> mNext{};
+    std::array<Slot, Capacity> mPrev{};
+    std::array<Slot, INDEX_SIZE> mIndex{};
+
+    Slot mFree = NIL;
+    Slot mHead = NIL;
+    Slot mTail = NIL;
+    std::size_t mSize = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_ORDERSLAB_H
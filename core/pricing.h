@@ -0,0 +1,98 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_PRICING_H
+#define CPPREADY_TRADER_GO_PRICING_H
+
+#include <array>
+#include <cstddef>
+
+#include <ready_trader_go/types.h>
+
+#include "sidetraits.h"
+
+// Exact integer price arithmetic.
+//
+// Every function rounds once, over the whole calculation, in the direction
+// it is asked to, so the results are exact. Divisors are template arguments:
+// the compiler turns each division into a multiply and a shift.
+
+constexpr unsigned long BASIS_POINTS = 10000;
+
+enum class PriceRounding { DOWN, UP };
+
+// numerator / Divisor rounded in the given direction.
+template <unsigned long Divisor>
+constexpr unsigned long DivideRounded(unsigned long numerator,
+                                      PriceRounding rounding) {
+    static_assert(Divisor != 0, "division by zero");
+    return (rounding == PriceRounding::UP) ? (numerator + Divisor - 1) / Divisor
+                                           : numerator / Divisor;
+}
+
+// The nearest multiple of TickSize in the given direction.
+template <unsigned long TickSize>
+constexpr unsigned long SnapToTick(unsigned long price,
+                                   PriceRounding rounding) {
+    return DivideRounded<TickSize>(price, rounding) * TickSize;
+}
+
+// price * (1 + basis / 10000), snapped to TickSize in the given direction.
+// basis may be negative but must be above -10000.
+template <unsigned long TickSize>
+constexpr unsigned long ScaleByBasis(unsigned long price, long basis,
+                                     PriceRounding rounding) {
+    auto factor = static_cast<unsigned long>(
+        static_cast<long>(BASIS_POINTS) + basis);
+    return DivideRounded<BASIS_POINTS * TickSize>(price * factor, rounding) *
+           TickSize;
+}
+
+// Our quote on one side for a reference price: margin basis points outside
+// it, rounded away from the aggressive side (asks up, bids down) so margin
+// is never given away to rounding. A zero reference gives a zero quote.
+template <ReadyTraderGo::Side Side, unsigned long TickSize>
+constexpr unsigned long QuotePrice(unsigned long reference, long margin) {
+    using Traits = SideTraits<Side>;
+    return ScaleByBasis<TickSize>(reference, Traits::MARGIN_SIGN * margin,
+                                  Traits::ROUND_UP ? PriceRounding::UP
+                                                   : PriceRounding::DOWN);
+}
+
+// QuotePrice for every level of a book side at once. The loop has no
+// branches and a fixed trip count, so it is fully unrolled; 64-bit
+// multiply-high has no vector form on x86, so each level is a scalar
+// multiply-shift, issued back to back.
+template <ReadyTraderGo::Side Side, unsigned long TickSize, std::size_t N>
+constexpr void QuotePrices(const std::array<unsigned long, N> &references,
+                           long margin, std::array<unsigned long, N> &quotes) {
+    for (std::size_t i = 0; i < N; i++) {
+        quotes[i] = QuotePrice<Side, TickSize>(references[i], margin);
+    }
+}
+
+static_assert(QuotePrice<ReadyTraderGo::Side::SELL, 100>(10000, 7) == 10100,
+              "asks round up to the tick");
+static_assert(QuotePrice<ReadyTraderGo::Side::BUY, 100>(10000, 7) == 9900,
+              "bids round down to the tick");
+static_assert(QuotePrice<ReadyTraderGo::Side::SELL, 100>(1000000, 7) ==
+                  1000700,
+              "exact prices are not rounded");
+static_assert(QuotePrice<ReadyTraderGo::Side::BUY, 100>(0, 7) == 0,
+              "no reference, no quote");
+
+#endif // CPPREADY_TRADER_GO_PRICING_H
@@ -0,0 +1,181 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_QUOTELADDER_H
+#define CPPREADY_TRADER_GO_QUOTELADDER_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include <ready_trader_go/types.h>
+
+#include "messagescheduler.h"
+#include "orderslab.h"
+#include "pricing.h"
+#include "sidetraits.h"
+
+// A price we want an order resting at, and how big that order should be.
+struct LadderQuote {
+    unsigned long price;
+    unsigned long volume;
+};
+
+// The quotes we want on one side of the ETF book, and the actions that get
+// our resting orders there.
+//
+// The targets are one quote per level of the reference (future) book, best
+// first. Plan() walks the resting orders and the targets together, both
+// sorted best first, and stages only what differs:
+//
+// * a target with no order at its price gets an insert;
+// * an order at a target price is kept, and amended down if it is bigger
+//   than the target;
+// * an order more aggressive than the best target is cancelled at once;
+// * any other order off the ladder is cancelled only if there is budget to
+//   spare, unless its slot is needed for an insert.
+//
+// Inserts are limited, best first, by the orders we may have resting and by
+// how much more volume the position limit allows.
+template <ReadyTraderGo::Side Side> class QuoteLadder {
+public:
+    using Levels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+    // Quote margin basis points outside each of the first levels of the
+    // reference book, volume lots each. Empty reference levels end the
+    // ladder.
+    template <unsigned long TickSize>
+    void SetTargets(const Levels &references, std::size_t levels, long margin,
+                    unsigned long volume) {
+        std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> prices;
+        QuotePrices<Side, TickSize>(references, margin, prices);
+        levels = std::min(levels, prices.size());
+        mCount = 0;
+        while (mCount < levels && prices[mCount] != 0) {
+            mTargets[mCount] = {prices[mCount], volume};
+            mCount++;
+        }
+    }
+
+    std::size_t Size() const { return mCount; }
+    const LadderQuote &operator[](std::size_t i) const { return mTargets[i]; }
+
+    // Stage the actions that turn the resting orders into the targets.
+    // maxOrders bounds the orders resting on this side, including those
+    // still being cancelled; volumeRoom is the volume that may be added.
+    template <typename Slab>
+    void Plan(Slab &resting, std::size_t maxOrders, long volumeRoom,
+              MessageScheduler &scheduler) const {
+        std::array<bool, ReadyTraderGo::TOP_LEVEL_COUNT> covered{};
+        std::array<const typename Slab::Entry *, Slab::CAPACITY> spare;
+        std::size_t spareCount = 0;
+        std::size_t staleCount = 0;
+
+        std::size_t target = 0;
+        for (const auto &entry : resting) {
+            const Order &order = entry.order;
+            if (order.cancelling) {
+                continue;
+            }
+            while (target < mCount && Better(mTargets[target].price,
+                                             order.price)) {
+                target++;
+            }
+            if (target < mCount && mTargets[target].price == order.price) {
+                covered[target] = true;
+                Shrink(entry, mTargets[target].volume, scheduler);
+                target++;
+            } else if (mCount != 0 && Better(order.price, mTargets[0].price)) {
+                scheduler.Cancel(Side, entry.id, order.price,
+                                 OrderIntent::STALE);
+                staleCount++;
+            } else {
+                spare[spareCount++] = &entry;
+            }
+        }
+
+        std::array<LadderQuote, ReadyTraderGo::TOP_LEVEL_COUNT> inserts;
+        std::size_t insertCount = 0;
+        for (std::size_t i = 0; i < mCount && volumeRoom > 0; i++) {
+            if (covered[i] || mTargets[i].volume == 0) {
+                continue;
+            }
+            unsigned long volume = std::min<unsigned long>(
+                mTargets[i].volume, static_cast<unsigned long>(volumeRoom));
+            inserts[insertCount++] = {mTargets[i].price, volume};
+            volumeRoom -= static_cast<long>(volume);
+        }
+
+        // Stale cancels go out before any insert, so their orders' places
+        // can be taken straight away. Cancelled orders keep their slab
+        // entries until confirmed, though.
+        std::size_t live = resting.Size();
+        std::size_t room =
+            (maxOrders + staleCount > live) ? maxOrders + staleCount - live
+                                            : 0;
+        room = std::min(room, Slab::CAPACITY - live);
+
+        // Make room for the remaining inserts by cancelling the worst spare
+        // orders before them too.
+        std::size_t promoted = 0;
+        while (insertCount > room && promoted < spareCount &&
+               room < Slab::CAPACITY - live) {
+            promoted++;
+            room++;
+        }
+        for (std::size_t i = 0; i < spareCount; i++) {
+            bool needed = i >= spareCount - promoted;
+            scheduler.Cancel(Side, spare[i]->id, spare[i]->order.price,
+                             needed ? OrderIntent::STALE
+                                    : OrderIntent::SPARE);
+        }
+
+        for (std::size_t i = 0; i < insertCount && i < room; i++) {
+            scheduler.Insert(Side, inserts[i].price, inserts[i].volume);
+        }
+    }
+
+private:
+    static constexpr bool Better(unsigned long a, unsigned long b) {
+        return SideTraits<Side>::IsBetter(a, b);
+    }
+
+    // Amend the order down to the target volume, unless it is already no
+    // bigger or an amend to that size is in flight. A zero target would
+    // cancel the order, which is left to the ladder.
+    template <typename Entry>
+    static void Shrink(const Entry &entry, unsigned long volume,
+                       MessageScheduler &scheduler) {
+        const Order &order = entry.order;
+        if (volume == 0) {
+            return;
+        }
+        unsigned long target = order.filledVolume + volume;
+        unsigned long current = order.filledVolume + order.remainingVolume;
+        if (order.amendVolume != 0) {
+            current = order.amendVolume;
+        }
+        if (target < current) {
+            scheduler.Amend(Side, entry.id, order.price, target);
+        }
+    }
+
+    std::array<LadderQuote, ReadyTraderGo::TOP_LEVEL_COUNT> mTargets{};
+    std::size_t mCount = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_QUOTELADDER_H
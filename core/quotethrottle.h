@@ -0,0 +1,136 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_QUOTETHROTTLE_H
+#define CPPREADY_TRADER_GO_QUOTETHROTTLE_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "messagescheduler.h"
+
+// How the QuoteThrottle adapts.
+struct QuoteThrottleParams {
+    // Share of the quoting budget (the message limit less the hedge
+    // reserve) that requotes should use on average; zero turns the throttle
+    // off.
+    double targetUtilisation = 0.8;
+
+    // Share of the time between futures books that repricing may take.
+    double maxLoad = 0.25;
+
+    // Bounds on the re-quote interval and the tolerance.
+    std::uint64_t maxInterval = 1000000000; // nanoseconds
+    unsigned long maxTolerance = 3;         // ticks
+
+    // Weight of the newest sample in the running averages.
+    double smoothing = 0.1;
+};
+
+// Decides how often the ladders may be requoted, from how fast futures
+// books arrive, how many messages a requote sends and how long repricing
+// takes.
+//
+// The re-quote interval is the shortest gap between requotes that keeps
+// the average requote within targetUtilisation of the budget and repricing
+// within maxLoad of the time between books. While the interval has not
+// passed since the last requote, only a side whose reference price moved by
+// more than the tolerance is requoted; everything else waits. The tolerance
+// is how many books the interval spans, so a calm market, where the
+// interval passes between books, is quoted on every book as if there were
+// no throttle, and a busy one only chases the larger moves.
+class QuoteThrottle {
+public:
+    explicit QuoteThrottle(
+        const MessageBudget &budget = MessageBudget(),
+        const QuoteThrottleParams &params = QuoteThrottleParams())
+        : mParams(params),
+          mQuotingRate(
+              params.targetUtilisation *
+              static_cast<double>(budget.limit -
+                                  std::min(budget.limit, budget.hedgeReserve)) /
+              static_cast<double>(budget.interval)) {}
+
+    // A futures book arrived at the given time.
+    void OnBook(std::uint64_t now) {
+        if (mLastBook != 0 && now > mLastBook) {
+            Smooth(mBookInterval, static_cast<double>(now - mLastBook));
+            Adapt();
+        }
+        mLastBook = now;
+    }
+
+    // A reprice at the given time sent that many messages and took that
+    // many nanoseconds.
+    void OnReprice(std::uint64_t now, unsigned long messages,
+                   double processing) {
+        Smooth(mProcessing, processing);
+        if (messages != 0) {
+            Smooth(mMessagesPerRequote, static_cast<double>(messages));
+            mLastRequote = now;
+        }
+        Adapt();
+    }
+
+    // Whether a side whose reference price moved by the given number of
+    // ticks since it was last quoted may be requoted now.
+    bool Allow(std::uint64_t now, unsigned long moveTicks) const {
+        return moveTicks > mTolerance || now >= mLastRequote + mInterval;
+    }
+
+    std::uint64_t Interval() const { return mInterval; }
+    unsigned long Tolerance() const { return mTolerance; }
+
+private:
+    void Smooth(double &average, double sample) const {
+        average = (average == 0.0)
+                      ? sample
+                      : average + mParams.smoothing * (sample - average);
+    }
+
+    void Adapt() {
+        if (mQuotingRate <= 0.0) {
+            return;
+        }
+        double interval = std::max(mMessagesPerRequote / mQuotingRate,
+                                   mProcessing / mParams.maxLoad);
+        mInterval = std::min(static_cast<std::uint64_t>(interval),
+                             mParams.maxInterval);
+        mTolerance =
+            (mBookInterval == 0.0)
+                ? 0
+                : std::min(static_cast<unsigned long>(mInterval /
+                                                      mBookInterval),
+                           mParams.maxTolerance);
+    }
+
+    QuoteThrottleParams mParams;
+    // Quoting messages the budget allows per nanosecond.
+    double mQuotingRate;
+
+    std::uint64_t mLastBook = 0;
+    std::uint64_t mLastRequote = 0;
+    double mBookInterval = 0.0;
+    double mMessagesPerRequote = 0.0;
+    double mProcessing = 0.0;
+
+    std::uint64_t mInterval = 0;
+    unsigned long mTolerance = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_QUOTETHROTTLE_H
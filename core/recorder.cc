@@ -0,0 +1,162 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstring>
+
+#include "capture.h"
+#include "recorder.h"
+
+using namespace ReadyTraderGo;
+
+// How long the writer sleeps when it finds the ring empty.
+constexpr std::chrono::milliseconds WRITER_IDLE_SLEEP{1};
+
+static std::uint64_t EpochNanoseconds()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+Recorder::Recorder(const std::string& filename, const std::string& capturePrefix)
+    : mRing(std::make_unique<SpscRing<MarketRecord, RING_CAPACITY>>()),
+      mCapturePrefix(capturePrefix)
+{
+    mFile = std::fopen(filename.c_str(), "wb");
+    if (mFile == nullptr)
+    {
+        return;
+    }
+
+    RecordFileHeader header{};
+    std::memcpy(header.magic, RECORD_FILE_MAGIC, sizeof(header.magic));
+    header.version = RECORD_FILE_VERSION;
+    header.recordSize = sizeof(MarketRecord);
+    std::fwrite(&header, sizeof(header), 1, mFile);
+
+    mRunning.store(true, std::memory_order_relaxed);
+    mWriter = std::thread(&Recorder::WriterLoop, this);
+}
+
+Recorder::~Recorder()
+{
+    Close();
+}
+
+void Recorder::Close()
+{
+    if (mWriter.joinable())
+    {
+        mRunning.store(false, std::memory_order_release);
+        mWriter.join();
+    }
+    if (mFile != nullptr)
+    {
+        std::fclose(mFile);
+        mFile = nullptr;
+    }
+    for (auto& capture : mCaptures)
+    {
+        capture.reset();
+    }
+}
+
+void Recorder::Record(Instrument instrument,
+                      RecordType type,
+                      unsigned long sequenceNumber,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& askPrices,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& askVolumes,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& bidPrices,
+                      const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    MarketRecord record;
+    record.timestamp = EpochNanoseconds();
+    record.sequenceNumber = sequenceNumber;
+    record.instrument = static_cast<std::uint8_t>(instrument);
+    record.type = static_cast<std::uint8_t>(type);
+    std::memset(record.reserved, 0, sizeof(record.reserved));
+    record.askPrices = askPrices;
+    record.askVolumes = askVolumes;
+    record.bidPrices = bidPrices;
+    record.bidVolumes = bidVolumes;
+
+    if (!mRing->TryPush(record))
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::size_t Recorder::Drain()
+{
+    std::size_t total = 0;
+    const MarketRecord* records;
+    while (std::size_t count = mRing->Peek(&records))
+    {
+        std::fwrite(records, sizeof(MarketRecord), count, mFile);
+        if (!mCapturePrefix.empty())
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                Capture(records[i]);
+            }
+        }
+        mRing->Release(count);
+        total += count;
+    }
+    return total;
+}
+
+void Recorder::Capture(const MarketRecord& record)
+{
+    std::size_t index = record.instrument * 2 + record.type;
+    if (index >= CAPTURE_COUNT)
+    {
+        return;
+    }
+
+    auto& capture = mCaptures[index];
+    if (!capture)
+    {
+        auto instrument = static_cast<Instrument>(record.instrument);
+        auto type = static_cast<RecordType>(record.type);
+        std::string filename = mCapturePrefix
+                               + (instrument == Instrument::ETF ? "_etf" : "_future")
+                               + (type == RecordType::ORDER_BOOK ? "_book" : "_ticks")
+                               + ".col";
+        capture = std::make_unique<CaptureWriter>();
+        capture->Open(filename, instrument, type);
+    }
+    capture->Append(record);
+}
+
+void Recorder::WriterLoop()
+{
+    while (mRunning.load(std::memory_order_acquire))
+    {
+        if (Drain() == 0)
+        {
+            std::this_thread::sleep_for(WRITER_IDLE_SLEEP);
+        }
+    }
+    Drain();
+    std::fflush(mFile);
+}
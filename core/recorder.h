@@ -0,0 +1,122 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_RECORDER_H
+#define CPPREADY_TRADER_GO_RECORDER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <ready_trader_go/types.h>
+
+#include "spscring.h"
+
+enum class RecordType : std::uint8_t
+{
+    ORDER_BOOK = 0,
+    TRADE_TICKS = 1
+};
+
+// One market data message exactly as the exchange delivered it. Records are
+// written to disk as raw memory, so this must stay a fixed-size POD.
+struct MarketRecord
+{
+    std::uint64_t timestamp;      // nanoseconds since the Unix epoch
+    std::uint64_t sequenceNumber;
+    std::uint8_t instrument;      // ReadyTraderGo::Instrument
+    std::uint8_t type;            // RecordType
+    std::uint8_t reserved[6];
+    std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> askPrices;
+    std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> askVolumes;
+    std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> bidPrices;
+    std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT> bidVolumes;
+};
+
+static_assert(std::is_trivially_copyable<MarketRecord>::value, "MarketRecord must be POD");
+static_assert(sizeof(unsigned long) == 8, "capture files assume 64-bit prices and volumes");
+
+// The first bytes of every binary capture file.
+struct RecordFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+};
+
+constexpr char RECORD_FILE_MAGIC[8] = {'R', 'T', 'G', 'R', 'E', 'C', 'D', '\0'};
+constexpr std::uint32_t RECORD_FILE_VERSION = 1;
+
+class CaptureWriter;
+
+// Records market data to a binary file without blocking the caller.
+//
+// Record() copies the message into a lock-free ring and returns; a background
+// thread drains the ring in batches and does all of the file I/O. If the disk
+// falls so far behind that the ring fills up, new records are dropped (and
+// counted) rather than stalling the thread that is trading.
+//
+// Given a capture prefix, the writer thread also appends every record to a
+// columnar capture per instrument and message type, named
+// "<prefix>_<etf|future>_<book|ticks>.col" (see capture.h).
+class Recorder
+{
+public:
+    static constexpr std::size_t RING_CAPACITY = 1 << 14;
+    static constexpr std::size_t CAPTURE_COUNT = 4;
+
+    explicit Recorder(const std::string& filename, const std::string& capturePrefix = "");
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Stop the writer thread, flush everything still queued and close the file.
+    void Close();
+
+    // Number of records dropped because the ring was full.
+    unsigned long Dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+    void Record(ReadyTraderGo::Instrument instrument,
+                RecordType type,
+                unsigned long sequenceNumber,
+                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askPrices,
+                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& askVolumes,
+                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidPrices,
+                const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>& bidVolumes);
+
+private:
+    // Write out everything currently in the ring. Returns the record count.
+    std::size_t Drain();
+    void WriterLoop();
+    void Capture(const MarketRecord& record);
+
+    std::unique_ptr<SpscRing<MarketRecord, RING_CAPACITY>> mRing;
+    std::FILE* mFile = nullptr;
+    std::string mCapturePrefix;
+    std::array<std::unique_ptr<CaptureWriter>, CAPTURE_COUNT> mCaptures;
+    std::thread mWriter;
+    std::atomic<bool> mRunning{false};
+    std::atomic<unsigned long> mDropped{0};
+};
+
+#endif //CPPREADY_TRADER_GO_RECORDER_H
@@ -0,0 +1,131 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_RISKGATE_H
+#define CPPREADY_TRADER_GO_RISKGATE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+
+#include <ready_trader_go/types.h>
+
+// The exchange's limits, as in the Limits section of exchange.json.
+struct RiskLimits {
+    long positionLimit = 100;
+    long activeVolumeLimit = 200;
+    long activeOrderCountLimit = 10;
+};
+
+// Pre-trade checks against the exchange's limits.
+//
+// Keeps exact running totals of the ETF position, the volume resting on
+// each side and the number of active orders, so every check is a handful of
+// comparisons. An insert is refused if, with every resting order on its side
+// and the insert itself filled, the position could pass the limit, or if it
+// would take the active volume or order count past theirs. Cancels always
+// reduce risk and are never checked.
+class RiskGate {
+public:
+    explicit RiskGate(const RiskLimits &limits = RiskLimits())
+        : mLimits(limits) {}
+
+    bool AllowInsert(ReadyTraderGo::Side side, unsigned long volume) const {
+        long lots = static_cast<long>(volume);
+        bool position = PositionRoom(side) >= lots;
+        bool active = mActiveVolume + lots <= mLimits.activeVolumeLimit;
+        bool count = mActiveOrders < mLimits.activeOrderCountLimit;
+        return position & active & count & (lots > 0);
+    }
+
+    // Amends may only reduce an order's volume. Volumes are totals,
+    // including what has already filled, as the exchange takes them; an
+    // amend to no more than the filled volume would cancel the order.
+    bool AllowAmend(unsigned long filledVolume, unsigned long currentVolume,
+                    unsigned long newVolume) const {
+        return (newVolume < currentVolume) & (newVolume > filledVolume);
+    }
+
+    // A hedge may take the futures position (including hedges in flight)
+    // anywhere within the limit, or closer to zero if it is already beyond.
+    bool AllowHedge(long futurePosition, long volume) const {
+        long after = std::labs(futurePosition + volume);
+        return after <= std::max(mLimits.positionLimit,
+                                 std::labs(futurePosition));
+    }
+
+    // Lots an insert on a side may have for the checks to pass.
+    long InsertRoom(ReadyTraderGo::Side side) const {
+        return std::max(0L, std::min(PositionRoom(side),
+                                     mLimits.activeVolumeLimit -
+                                         mActiveVolume));
+    }
+
+    void Inserted(ReadyTraderGo::Side side, unsigned long volume) {
+        long lots = static_cast<long>(volume);
+        mResting[Index(side)] += lots;
+        mActiveVolume += lots;
+        mActiveOrders++;
+    }
+
+    // Account for an order status: filled lots have traded and reduced lots
+    // (filled or cancelled) no longer rest. Closed orders are no longer
+    // active.
+    void Updated(ReadyTraderGo::Side side, long filled, long reduced,
+                 bool closed) {
+        mPosition += Direction(side) * filled;
+        mResting[Index(side)] -= reduced;
+        mActiveVolume -= reduced;
+        mActiveOrders -= closed;
+    }
+
+    // Take up a position from an earlier run, before any orders are tracked.
+    void RestorePosition(long position) { mPosition = position; }
+
+    long Position() const { return mPosition; }
+    long Resting(ReadyTraderGo::Side side) const {
+        return mResting[Index(side)];
+    }
+    long ActiveVolume() const { return mActiveVolume; }
+    long ActiveOrders() const { return mActiveOrders; }
+
+private:
+    static std::size_t Index(ReadyTraderGo::Side side) {
+        return static_cast<std::size_t>(side);
+    }
+
+    // One for buys, minus one for sells.
+    static long Direction(ReadyTraderGo::Side side) {
+        return 2 * static_cast<long>(side) - 1;
+    }
+
+    // How far the side's resting orders could still move the position
+    // towards its limit.
+    long PositionRoom(ReadyTraderGo::Side side) const {
+        return mLimits.positionLimit - Direction(side) * mPosition -
+               mResting[Index(side)];
+    }
+
+    RiskLimits mLimits;
+    long mPosition = 0;
+    std::array<long, 2> mResting{};
+    long mActiveVolume = 0;
+    long mActiveOrders = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_RISKGATE_H
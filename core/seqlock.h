@@ -0,0 +1,88 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_SEQLOCK_H
+#define CPPREADY_TRADER_GO_SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// A value with one writer and any number of readers, none of which ever
+// block the writer.
+//
+// The writer makes the sequence number odd, stores the value and makes it
+// even again; a reader copies the value and retries if the sequence number
+// was odd or changed meanwhile. The value is held as atomic words so that a
+// reader racing the writer is well defined even across processes; on x86
+// the relaxed word loads and stores are plain moves.
+template <typename T> class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "seqlock values are copied as raw memory");
+
+    static constexpr std::size_t WORD_COUNT =
+        (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+public:
+    // Only ever called from the one writer.
+    void Store(const T &value) {
+        std::array<std::uint64_t, WORD_COUNT> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        std::uint64_t sequence = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORD_COUNT; i++) {
+            mWords[i].store(words[i], std::memory_order_relaxed);
+        }
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // A consistent copy of the last value stored.
+    T Load() const {
+        std::array<std::uint64_t, WORD_COUNT> words;
+        for (;;) {
+            std::uint64_t before = mSequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                continue;
+            }
+            for (std::size_t i = 0; i < WORD_COUNT; i++) {
+                words[i] = mWords[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mSequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+    // Number of stores so far.
+    std::uint64_t Version() const {
+        return mSequence.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    std::atomic<std::uint64_t> mSequence{0};
+    std::array<std::atomic<std::uint64_t>, WORD_COUNT> mWords{};
+};
+
+#endif // CPPREADY_TRADER_GO_SEQLOCK_H
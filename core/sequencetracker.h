@@ -0,0 +1,99 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_SEQUENCETRACKER_H
+#define CPPREADY_TRADER_GO_SEQUENCETRACKER_H
+
+#include <array>
+#include <cstddef>
+
+#include <ready_trader_go/types.h>
+
+// The information messages that carry a sequence number.
+enum class FeedMessage : std::size_t { ORDER_BOOK, TRADE_TICKS, COUNT };
+
+inline const char *FeedMessageName(FeedMessage message) {
+    return (message == FeedMessage::ORDER_BOOK) ? "order book" : "trade ticks";
+}
+
+struct SequenceCounters {
+    unsigned long accepted = 0;
+    // Messages no newer than one already accepted, and dropped.
+    unsigned long stale = 0;
+    // Jumps of more than one, and the sequence numbers they skipped.
+    unsigned long gaps = 0;
+    unsigned long skipped = 0;
+};
+
+// The last sequence number seen for each instrument and message type, so
+// that the two instruments' feeds, and the books and ticks of one
+// instrument, never mask each other.
+//
+// Trade ticks are only sent when there was trading, so gaps in them are
+// normal; gaps in a book feed mean messages were lost.
+class SequenceTracker {
+public:
+    // Returns false if the message is stale and should be dropped.
+    bool Accept(ReadyTraderGo::Instrument instrument, FeedMessage message,
+                unsigned long sequenceNumber) {
+        std::size_t i = Index(instrument, message);
+        SequenceCounters &counters = mCounters[i];
+        unsigned long last = mLast[i];
+        if (sequenceNumber <= last) {
+            counters.stale++;
+            return false;
+        }
+        if (last != 0 && sequenceNumber != last + 1) {
+            counters.gaps++;
+            counters.skipped += sequenceNumber - last - 1;
+        }
+        counters.accepted++;
+        mLast[i] = sequenceNumber;
+        return true;
+    }
+
+    // Carry on from the last sequence number an earlier run accepted.
+    void Restore(ReadyTraderGo::Instrument instrument, FeedMessage message,
+                 unsigned long sequenceNumber) {
+        mLast[Index(instrument, message)] = sequenceNumber;
+    }
+
+    unsigned long Last(ReadyTraderGo::Instrument instrument,
+                       FeedMessage message) const {
+        return mLast[Index(instrument, message)];
+    }
+
+    const SequenceCounters &Counters(ReadyTraderGo::Instrument instrument,
+                                     FeedMessage message) const {
+        return mCounters[Index(instrument, message)];
+    }
+
+private:
+    static constexpr std::size_t MESSAGE_COUNT =
+        static_cast<std::size_t>(FeedMessage::COUNT);
+
+    static std::size_t Index(ReadyTraderGo::Instrument instrument,
+                             FeedMessage message) {
+        return static_cast<std::size_t>(instrument) * MESSAGE_COUNT +
+               static_cast<std::size_t>(message);
+    }
+
+    std::array<unsigned long, 2 * MESSAGE_COUNT> mLast{};
+    std::array<SequenceCounters, 2 * MESSAGE_COUNT> mCounters{};
+};
+
+#endif // CPPREADY_TRADER_GO_SEQUENCETRACKER_H
@@ -0,0 +1,215 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_SESSIONARENA_H
+#define CPPREADY_TRADER_GO_SESSIONARENA_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+// Memory for everything the autotrader allocates while trading.
+//
+// In practice that is the handlers it hands to Boost.Asio: each posted
+// reprice or hedge and each wait on the hedge timer. A pool carves them out
+// of one buffer and takes them back when they have run, so after the first
+// few events the same blocks are reused and the trader never calls into
+// malloc. Only if the buffer runs out does the pool fall back to the heap.
+//
+// Allocators share ownership of the arena, so handlers still queued in an
+// io_context when the trader is destroyed can still be freed. The pool is
+// not thread safe: one trader's handlers must all run on one thread.
+class SessionArena {
+public:
+    static constexpr std::size_t CAPACITY = 16 * 1024;
+
+    SessionArena()
+        : mMonotonic(mBuffer.data(), mBuffer.size(),
+                     std::pmr::new_delete_resource()),
+          mPool(&mMonotonic) {}
+
+    SessionArena(const SessionArena &) = delete;
+    SessionArena &operator=(const SessionArena &) = delete;
+
+    std::pmr::memory_resource *Resource() { return &mPool; }
+
+private:
+    alignas(std::max_align_t) std::array<std::byte, CAPACITY> mBuffer;
+    std::pmr::monotonic_buffer_resource mMonotonic;
+    std::pmr::unsynchronized_pool_resource mPool;
+};
+
+template <typename T> class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<SessionArena> arena) noexcept
+        : mArena(std::move(arena)) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+        : mArena(other.mArena) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(
+            mArena->Resource()->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept {
+        mArena->Resource()->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const noexcept {
+        return mArena == other.mArena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const noexcept {
+        return mArena != other.mArena;
+    }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+
+    std::shared_ptr<SessionArena> mArena;
+};
+
+// A completion handler that Boost.Asio allocates from a SessionArena.
+template <typename Handler> class ArenaHandler {
+public:
+    using allocator_type = ArenaAllocator<std::byte>;
+
+    ArenaHandler(const std::shared_ptr<SessionArena> &arena, Handler handler)
+        : mAllocator(arena), mHandler(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return mAllocator; }
+
+    template <typename... Args> void operator()(Args &&...args) {
+        mHandler(std::forward<Args>(args)...);
+    }
+
+private:
+    allocator_type mAllocator;
+    Handler mHandler;
+};
+
+template <typename Handler>
+ArenaHandler<std::decay_t<Handler>>
+InArena(const std::shared_ptr<SessionArena> &arena, Handler &&handler) {
+    return {arena, std::forward<Handler>(handler)};
+}
+
+// Memory for one handler at a time, which may be allocated on one thread
+// and freed on another.
+//
+// For a handler that is only ever posted again after the last post has run,
+// such as the IoBridge's drain: Boost.Asio frees a handler's memory before
+// calling it, so every post reuses the same block. A second allocation while
+// the block is taken, or one too large for it, falls back to the heap.
+class HandlerSlot {
+public:
+    static constexpr std::size_t CAPACITY = 256;
+
+    HandlerSlot() = default;
+    HandlerSlot(const HandlerSlot &) = delete;
+    HandlerSlot &operator=(const HandlerSlot &) = delete;
+
+    void *Allocate(std::size_t size) {
+        if (size <= CAPACITY &&
+            !mTaken.exchange(true, std::memory_order_acquire)) {
+            return mBuffer.data();
+        }
+        return ::operator new(size);
+    }
+
+    void Deallocate(void *p) noexcept {
+        if (p == mBuffer.data()) {
+            mTaken.store(false, std::memory_order_release);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+private:
+    alignas(std::max_align_t) std::array<std::byte, CAPACITY> mBuffer;
+    std::atomic<bool> mTaken{false};
+};
+
+template <typename T> class SlotAllocator {
+public:
+    using value_type = T;
+
+    explicit SlotAllocator(HandlerSlot *slot) noexcept : mSlot(slot) {}
+
+    template <typename U>
+    SlotAllocator(const SlotAllocator<U> &other) noexcept
+        : mSlot(other.mSlot) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(mSlot->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t) noexcept { mSlot->Deallocate(p); }
+
+    template <typename U>
+    bool operator==(const SlotAllocator<U> &other) const noexcept {
+        return mSlot == other.mSlot;
+    }
+
+    template <typename U>
+    bool operator!=(const SlotAllocator<U> &other) const noexcept {
+        return mSlot != other.mSlot;
+    }
+
+private:
+    template <typename U> friend class SlotAllocator;
+
+    HandlerSlot *mSlot;
+};
+
+// A completion handler that Boost.Asio allocates from a HandlerSlot.
+template <typename Handler> class SlotHandler {
+public:
+    using allocator_type = SlotAllocator<std::byte>;
+
+    SlotHandler(HandlerSlot *slot, Handler handler)
+        : mAllocator(slot), mHandler(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return mAllocator; }
+
+    template <typename... Args> void operator()(Args &&...args) {
+        mHandler(std::forward<Args>(args)...);
+    }
+
+private:
+    allocator_type mAllocator;
+    Handler mHandler;
+};
+
+template <typename Handler>
+SlotHandler<std::decay_t<Handler>> InSlot(HandlerSlot *slot,
+                                          Handler &&handler) {
+    return {slot, std::forward<Handler>(handler)};
+}
+
+#endif // CPPREADY_TRADER_GO_SESSIONARENA_H
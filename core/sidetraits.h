@@ -0,0 +1,91 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_SIDETRAITS_H
+#define CPPREADY_TRADER_GO_SIDETRAITS_H
+
+#include <functional>
+
+#include <ready_trader_go/types.h>
+
+#include "booksnapshot.h"
+
+// Everything that differs between the two sides of the book, for code
+// templated on a side: each side's instantiation is compiled with these as
+// constants, so the mirrored comparisons and signs cost no branches.
+template <ReadyTraderGo::Side S> struct SideTraits;
+
+template <> struct SideTraits<ReadyTraderGo::Side::SELL> {
+    static constexpr ReadyTraderGo::Side OTHER = ReadyTraderGo::Side::BUY;
+
+    // Asks are better the lower they are.
+    using Better = std::less<unsigned long>;
+    static constexpr bool IsBetter(unsigned long a, unsigned long b) {
+        return a < b;
+    }
+
+    // A fill on this side moves the position by this much per lot.
+    static constexpr long DIRECTION = -1;
+
+    // The sign of a margin, and the direction of rounding, that move a
+    // price on this side away from the market.
+    static constexpr long MARGIN_SIGN = 1;
+    static constexpr bool ROUND_UP = true;
+
+    // The lowest price on the tick grid an order on this side may have,
+    // which trades with any bid.
+    template <unsigned long TickSize>
+    static constexpr unsigned long MARKETABLE_PRICE =
+        (static_cast<unsigned long>(ReadyTraderGo::MINIMUM_BID) + TickSize) /
+        TickSize * TickSize;
+
+    // The book levels our orders on this side are quoted off, and the
+    // change flag for them.
+    static const BookSnapshot::Levels &Prices(const BookSnapshot &book) {
+        return book.askPrices;
+    }
+    static constexpr unsigned PRICE_CHANGES = ASK_PRICES;
+};
+
+template <> struct SideTraits<ReadyTraderGo::Side::BUY> {
+    static constexpr ReadyTraderGo::Side OTHER = ReadyTraderGo::Side::SELL;
+
+    // Bids are better the higher they are.
+    using Better = std::greater<unsigned long>;
+    static constexpr bool IsBetter(unsigned long a, unsigned long b) {
+        return a > b;
+    }
+
+    static constexpr long DIRECTION = 1;
+
+    static constexpr long MARGIN_SIGN = -1;
+    static constexpr bool ROUND_UP = false;
+
+    // The highest price on the tick grid, which trades with any ask.
+    template <unsigned long TickSize>
+    static constexpr unsigned long MARKETABLE_PRICE =
+        static_cast<unsigned long>(ReadyTraderGo::MAXIMUM_ASK) / TickSize *
+        TickSize;
+
+    static const BookSnapshot::Levels &Prices(const BookSnapshot &book) {
+        return book.bidPrices;
+    }
+    static constexpr unsigned PRICE_CHANGES = BID_PRICES;
+};
+
+#endif // CPPREADY_TRADER_GO_SIDETRAITS_H
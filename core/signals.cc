@@ -0,0 +1,83 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include "signals.h"
+
+using namespace ReadyTraderGo;
+
+namespace {
+
+// Weight of the newest trade ticks message in the running averages.
+constexpr double TRADE_SMOOTHING = 0.1;
+
+} // namespace
+
+void MarketSignals::OnOrderBook(Instrument instrument,
+                                const Levels &askPrices,
+                                const Levels &askVolumes,
+                                const Levels &bidPrices,
+                                const Levels &bidVolumes) {
+    std::size_t i = Index(instrument);
+
+    double askDepth = 0.0;
+    double bidDepth = 0.0;
+    for (std::size_t level = 0; level < TOP_LEVEL_COUNT; level++) {
+        askDepth += askVolumes[level];
+        bidDepth += bidVolumes[level];
+    }
+    double depth = askDepth + bidDepth;
+    mDepthImbalance[i] = (depth > 0.0) ? (bidDepth - askDepth) / depth : 0.0;
+
+    double topVolume = static_cast<double>(askVolumes[0] + bidVolumes[0]);
+    if (askPrices[0] == 0 || bidPrices[0] == 0 || topVolume == 0.0) {
+        mMicroprice[i] = 0.0;
+        mMicropriceOffset[i] = 0.0;
+        return;
+    }
+    double ask = static_cast<double>(askPrices[0]);
+    double bid = static_cast<double>(bidPrices[0]);
+    mMicroprice[i] = (bid * askVolumes[0] + ask * bidVolumes[0]) / topVolume;
+    mMicropriceOffset[i] = mMicroprice[i] - (ask + bid) / 2.0;
+}
+
+void MarketSignals::OnTradeTicks(Instrument instrument,
+                                 const Levels &askPrices,
+                                 const Levels &askVolumes,
+                                 const Levels &bidPrices,
+                                 const Levels &bidVolumes) {
+    std::size_t i = Index(instrument);
+
+    // Unused levels are zero in both arrays, so they add nothing.
+    double atAsks = 0.0;
+    double atBids = 0.0;
+    double notional = 0.0;
+    for (std::size_t level = 0; level < TOP_LEVEL_COUNT; level++) {
+        atAsks += askVolumes[level];
+        atBids += bidVolumes[level];
+        notional += static_cast<double>(askPrices[level]) * askVolumes[level] +
+                    static_cast<double>(bidPrices[level]) * bidVolumes[level];
+    }
+    double traded = atAsks + atBids;
+    if (traded == 0.0) {
+        return;
+    }
+
+    double imbalance = (atAsks - atBids) / traded;
+    mTradeImbalance[i] += TRADE_SMOOTHING * (imbalance - mTradeImbalance[i]);
+    mVwapNotional[i] += TRADE_SMOOTHING * (notional - mVwapNotional[i]);
+    mVwapVolume[i] += TRADE_SMOOTHING * (traded - mVwapVolume[i]);
+}
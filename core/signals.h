@@ -0,0 +1,89 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_SIGNALS_H
+#define CPPREADY_TRADER_GO_SIGNALS_H
+
+#include <array>
+#include <cstddef>
+
+#include <ready_trader_go/types.h>
+
+// Short-horizon signals for both instruments, updated incrementally from
+// every book and trade ticks message.
+//
+// Each signal is one array indexed by Instrument, so the reprice reads the
+// few doubles it needs from adjacent memory. Every update is O(1): a fixed
+// five-level pass and an exponentially weighted step, with nothing kept
+// per trade.
+class MarketSignals {
+public:
+    using Levels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+    void OnOrderBook(ReadyTraderGo::Instrument instrument,
+                     const Levels &askPrices, const Levels &askVolumes,
+                     const Levels &bidPrices, const Levels &bidVolumes);
+    void OnTradeTicks(ReadyTraderGo::Instrument instrument,
+                      const Levels &askPrices, const Levels &askVolumes,
+                      const Levels &bidPrices, const Levels &bidVolumes);
+
+    // Average of (volume traded at asks - volume traded at bids) / total
+    // over recent trade ticks, from -1 (sellers hitting bids) to 1 (buyers
+    // lifting asks).
+    double TradeImbalance(ReadyTraderGo::Instrument instrument) const {
+        return mTradeImbalance[Index(instrument)];
+    }
+
+    // Exponentially weighted VWAP of recent trades in cents, or zero before
+    // the first trade.
+    double Vwap(ReadyTraderGo::Instrument instrument) const {
+        std::size_t i = Index(instrument);
+        return (mVwapVolume[i] > 0.0) ? mVwapNotional[i] / mVwapVolume[i]
+                                      : 0.0;
+    }
+
+    // Best bid and ask weighted by the volume opposite them, in cents; zero
+    // unless the last book was two-sided.
+    double Microprice(ReadyTraderGo::Instrument instrument) const {
+        return mMicroprice[Index(instrument)];
+    }
+
+    // Microprice minus the plain mid, in cents.
+    double MicropriceOffset(ReadyTraderGo::Instrument instrument) const {
+        return mMicropriceOffset[Index(instrument)];
+    }
+
+    // (bid volume - ask volume) / total over all the reported levels of the
+    // last book.
+    double DepthImbalance(ReadyTraderGo::Instrument instrument) const {
+        return mDepthImbalance[Index(instrument)];
+    }
+
+private:
+    static std::size_t Index(ReadyTraderGo::Instrument instrument) {
+        return static_cast<std::size_t>(instrument);
+    }
+
+    std::array<double, 2> mTradeImbalance{};
+    std::array<double, 2> mVwapNotional{};
+    std::array<double, 2> mVwapVolume{};
+    std::array<double, 2> mMicroprice{};
+    std::array<double, 2> mMicropriceOffset{};
+    std::array<double, 2> mDepthImbalance{};
+};
+
+#endif // CPPREADY_TRADER_GO_SIGNALS_H
@@ -0,0 +1,103 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_SPSCRING_H
+#define CPPREADY_TRADER_GO_SPSCRING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Each side keeps a cached copy of the other side's index so that the
+// shared cache lines are only touched when the cached value runs out.
+template<typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "ring elements are copied as raw memory");
+
+    static constexpr std::size_t MASK = Capacity - 1;
+    static constexpr std::size_t CACHE_LINE = 64;
+
+public:
+    // Producer side. Returns false, without blocking, if the ring is full.
+    bool TryPush(const T& item)
+    {
+        std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mCachedTail == Capacity)
+        {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head - mCachedTail == Capacity)
+            {
+                return false;
+            }
+        }
+        mBuffer[head & MASK] = item;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Points items at the oldest unread element and returns how
+    // many elements follow it contiguously in memory (zero if the ring is
+    // empty). The elements stay valid until they are handed back with Release.
+    std::size_t Peek(const T** items)
+    {
+        std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (mCachedHead == tail)
+        {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (mCachedHead == tail)
+            {
+                return 0;
+            }
+        }
+        std::size_t available = mCachedHead - tail;
+        std::size_t untilWrap = Capacity - (tail & MASK);
+        *items = &mBuffer[tail & MASK];
+        return available < untilWrap ? available : untilWrap;
+    }
+
+    // Either side, or any other thread. Only a snapshot: the answer may be
+    // stale by the time the caller looks at it.
+    bool Empty() const
+    {
+        return mHead.load(std::memory_order_acquire) ==
+               mTail.load(std::memory_order_acquire);
+    }
+
+    // Consumer side. Frees the first count elements returned by Peek.
+    void Release(std::size_t count)
+    {
+        mTail.store(mTail.load(std::memory_order_relaxed) + count,
+                    std::memory_order_release);
+    }
+
+private:
+    alignas(CACHE_LINE) std::atomic<std::size_t> mHead{0};
+    std::size_t mCachedTail = 0;
+
+    alignas(CACHE_LINE) std::atomic<std::size_t> mTail{0};
+    std::size_t mCachedHead = 0;
+
+    alignas(CACHE_LINE) std::array<T, Capacity> mBuffer;
+};
+
+#endif //CPPREADY_TRADER_GO_SPSCRING_H
@@ -0,0 +1,305 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "statejournal.h"
+
+namespace bip = boost::interprocess;
+
+using namespace ReadyTraderGo;
+
+namespace {
+
+constexpr char STATE_JOURNAL_MAGIC[8] = "RTGJRNL";
+constexpr std::uint32_t STATE_JOURNAL_VERSION = 1;
+constexpr std::size_t HEADER_SIZE = 4096;
+
+// The largest snapshot, which has to fit in a region with room to spare.
+constexpr std::size_t SNAPSHOT_RECORDS =
+    2 + JournalState::FEED_COUNT + JournalState::MAX_ORDERS +
+    JournalState::MAX_HEDGES;
+
+static_assert(SNAPSHOT_RECORDS * 4 < StateJournal::REGION_RECORDS,
+              "state journal regions too small for a snapshot");
+
+template <typename Entry, std::size_t N>
+Entry *Find(std::array<Entry, N> &entries, std::size_t count,
+            unsigned long id) {
+    for (std::size_t i = 0; i < count; i++) {
+        if (entries[i].id == id) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+template <typename Entry, std::size_t N>
+void Remove(std::array<Entry, N> &entries, std::size_t &count, Entry *entry) {
+    *entry = entries[--count];
+}
+
+} // namespace
+
+bool ReadStateJournalEnabled(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        return false;
+    }
+
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(file, tree);
+    return tree.get<bool>("StateJournal.Enabled", false);
+}
+
+struct StateJournal::FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    // The generation being written, times two, plus the region it is in.
+    std::uint64_t active;
+};
+
+static_assert(sizeof(JournalRecord) == 40, "unexpected journal record size");
+
+StateJournal::StateJournal(const std::string &filename) {
+    constexpr std::size_t fileSize =
+        HEADER_SIZE + 2 * REGION_RECORDS * sizeof(JournalRecord);
+
+    std::error_code error;
+    std::uintmax_t existing = std::filesystem::file_size(filename, error);
+    bool create = error || existing == 0;
+    if (!create && existing != fileSize) {
+        throw std::runtime_error(filename + " is not a state journal");
+    }
+
+    try {
+        if (create) {
+            std::ofstream(filename, std::ios::binary | std::ios::trunc);
+            std::filesystem::resize_file(filename, fileSize);
+        }
+        bip::file_mapping file(filename.c_str(), bip::read_write);
+        mRegion = bip::mapped_region(file, bip::read_write, 0, fileSize);
+    } catch (const std::exception &e) {
+        throw std::runtime_error("could not map state journal " + filename +
+                                 ": " + e.what());
+    }
+    // Fault the pages in now rather than in the handlers.
+    mRegion.advise(bip::mapped_region::advice_willneed);
+
+    mHeader = static_cast<FileHeader *>(mRegion.get_address());
+    if (create) {
+        new (mHeader) FileHeader{};
+        std::memcpy(mHeader->magic, STATE_JOURNAL_MAGIC,
+                    sizeof(mHeader->magic));
+        mHeader->version = STATE_JOURNAL_VERSION;
+        mHeader->recordSize = sizeof(JournalRecord);
+        mHeader->active = 2; // generation one, in the first region.
+    } else if (std::memcmp(mHeader->magic, STATE_JOURNAL_MAGIC,
+                           sizeof(mHeader->magic)) != 0 ||
+               mHeader->version != STATE_JOURNAL_VERSION ||
+               mHeader->recordSize != sizeof(JournalRecord)) {
+        throw std::runtime_error(filename +
+                                 " is not a compatible state journal");
+    }
+
+    std::uint64_t active = __atomic_load_n(&mHeader->active, __ATOMIC_ACQUIRE);
+    mActive = active % 2;
+    mGeneration = static_cast<std::uint32_t>(active / 2);
+
+    const JournalRecord *records = Region(mActive);
+    while (mUsed < REGION_RECORDS &&
+           __atomic_load_n(&records[mUsed].generation, __ATOMIC_ACQUIRE) ==
+               mGeneration) {
+        Apply(mState, records[mUsed]);
+        mUsed++;
+    }
+    mRecovered = mUsed != 0;
+}
+
+void StateJournal::Clear() {
+    mState = JournalState();
+    mRecovered = false;
+    Compact();
+}
+
+void StateJournal::Position(long etfPosition, long futurePosition) {
+    Append({0, JournalRecord::POSITION, 0, 0, 0, etfPosition, futurePosition,
+            0});
+}
+
+void StateJournal::Order(unsigned long id, Side side, unsigned long price,
+                         unsigned long remainingVolume,
+                         unsigned long filledVolume) {
+    Append({0, JournalRecord::ORDER, static_cast<std::uint8_t>(side), 0, id,
+            static_cast<std::int64_t>(price),
+            static_cast<std::int64_t>(remainingVolume),
+            static_cast<std::int64_t>(filledVolume)});
+}
+
+void StateJournal::Hedge(unsigned long id, long volume) {
+    Append({0, JournalRecord::HEDGE, 0, 0, id, volume, 0, 0});
+}
+
+void StateJournal::Sequence(Instrument instrument, FeedMessage message,
+                            unsigned long sequenceNumber) {
+    Append({0, JournalRecord::SEQUENCE, 0, 0,
+            JournalState::Feed(instrument, message),
+            static_cast<std::int64_t>(sequenceNumber), 0, 0});
+}
+
+void StateJournal::NextOrderId(unsigned long id) {
+    Append({0, JournalRecord::NEXT_ID, 0, 0, id, 0, 0, 0});
+}
+
+void StateJournal::Apply(JournalState &state, const JournalRecord &record) {
+    switch (record.kind) {
+    case JournalRecord::POSITION:
+        state.etfPosition = record.a;
+        state.futurePosition = record.b;
+        break;
+    case JournalRecord::ORDER: {
+        state.nextOrderId = std::max<unsigned long>(state.nextOrderId,
+                                                    record.id + 1);
+        JournalState::Order *order =
+            Find(state.orders, state.orderCount, record.id);
+        if (record.b == 0) {
+            if (order != nullptr) {
+                Remove(state.orders, state.orderCount, order);
+            }
+            break;
+        }
+        if (order == nullptr) {
+            if (state.orderCount == JournalState::MAX_ORDERS) {
+                break;
+            }
+            order = &state.orders[state.orderCount++];
+        }
+        *order = {record.id, static_cast<Side>(record.side),
+                  static_cast<unsigned long>(record.a),
+                  static_cast<unsigned long>(record.b),
+                  static_cast<unsigned long>(record.c)};
+        break;
+    }
+    case JournalRecord::HEDGE: {
+        state.nextOrderId = std::max<unsigned long>(state.nextOrderId,
+                                                    record.id + 1);
+        JournalState::Hedge *hedge =
+            Find(state.hedges, state.hedgeCount, record.id);
+        if (record.a == 0) {
+            if (hedge != nullptr) {
+                Remove(state.hedges, state.hedgeCount, hedge);
+            }
+            break;
+        }
+        if (hedge == nullptr) {
+            if (state.hedgeCount == JournalState::MAX_HEDGES) {
+                break;
+            }
+            hedge = &state.hedges[state.hedgeCount++];
+        }
+        *hedge = {record.id, record.a};
+        break;
+    }
+    case JournalRecord::SEQUENCE:
+        if (record.id < JournalState::FEED_COUNT) {
+            state.sequences[record.id] = static_cast<unsigned long>(record.a);
+        }
+        break;
+    case JournalRecord::NEXT_ID:
+        state.nextOrderId = std::max<unsigned long>(state.nextOrderId,
+                                                    record.id);
+        break;
+    }
+}
+
+JournalRecord *StateJournal::Region(std::size_t region) {
+    auto *base = static_cast<char *>(mRegion.get_address()) + HEADER_SIZE;
+    return reinterpret_cast<JournalRecord *>(base) + region * REGION_RECORDS;
+}
+
+void StateJournal::Append(JournalRecord record) {
+    Apply(mState, record);
+    if (mUsed == REGION_RECORDS) {
+        // The snapshot already includes this record.
+        Compact();
+        return;
+    }
+    Write(&Region(mActive)[mUsed++], mGeneration, record);
+}
+
+void StateJournal::Write(JournalRecord *slot, std::uint32_t generation,
+                         JournalRecord record) {
+    slot->kind = record.kind;
+    slot->side = record.side;
+    slot->reserved = 0;
+    slot->id = record.id;
+    slot->a = record.a;
+    slot->b = record.b;
+    slot->c = record.c;
+    // Slots left over from older generations never match this one, so a
+    // record torn by a crash is where the replay stops.
+    __atomic_store_n(&slot->generation, generation, __ATOMIC_RELEASE);
+}
+
+void StateJournal::Compact() {
+    std::size_t region = 1 - mActive;
+    std::uint32_t generation = mGeneration + 1;
+    JournalRecord *records = Region(region);
+    std::size_t used = 0;
+
+    auto write = [&](JournalRecord record) {
+        Write(&records[used++], generation, record);
+    };
+    write({0, JournalRecord::NEXT_ID, 0, 0, mState.nextOrderId, 0, 0, 0});
+    write({0, JournalRecord::POSITION, 0, 0, 0, mState.etfPosition,
+           mState.futurePosition, 0});
+    for (std::size_t feed = 0; feed < JournalState::FEED_COUNT; feed++) {
+        write({0, JournalRecord::SEQUENCE, 0, 0, feed,
+               static_cast<std::int64_t>(mState.sequences[feed]), 0, 0});
+    }
+    for (std::size_t i = 0; i < mState.orderCount; i++) {
+        const JournalState::Order &order = mState.orders[i];
+        write({0, JournalRecord::ORDER, static_cast<std::uint8_t>(order.side),
+               0, order.id, static_cast<std::int64_t>(order.price),
+               static_cast<std::int64_t>(order.remainingVolume),
+               static_cast<std::int64_t>(order.filledVolume)});
+    }
+    for (std::size_t i = 0; i < mState.hedgeCount; i++) {
+        const JournalState::Hedge &hedge = mState.hedges[i];
+        write({0, JournalRecord::HEDGE, 0, 0, hedge.id, hedge.volume, 0, 0});
+    }
+
+    // The switch is a single store: until it lands, a replay still finds the
+    // old generation complete in the other region.
+    __atomic_store_n(&mHeader->active,
+                     static_cast<std::uint64_t>(generation) * 2 + region,
+                     __ATOMIC_RELEASE);
+    mActive = region;
+    mGeneration = generation;
+    mUsed = used;
+}
@@ -0,0 +1,164 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_STATEJOURNAL_H
+#define CPPREADY_TRADER_GO_STATEJOURNAL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <ready_trader_go/types.h>
+
+#include "sequencetracker.h"
+
+// Where the autotrader journals the state it needs to restart safely, and
+// what the journal is renamed to once a match has ended cleanly.
+constexpr char STATE_JOURNAL_FILENAME[] = "state_journal.dat";
+constexpr char STATE_JOURNAL_RETIRED_SUFFIX[] = ".last";
+
+// Whether the autotrader keeps a journal, from the optional StateJournal
+// section of its JSON configuration:
+//
+//     "StateJournal": {
+//       "Enabled": true
+//     }
+//
+// Off if the file or the section is missing.
+bool ReadStateJournalEnabled(const std::string &filename);
+
+// The trading state worth surviving a crash: the positions, the orders
+// resting and the hedges in flight, the newest sequence number of each feed
+// and the next free order id.
+struct JournalState {
+    static constexpr std::size_t MAX_ORDERS = 32;
+    static constexpr std::size_t MAX_HEDGES = 16;
+    static constexpr std::size_t FEED_COUNT =
+        2 * static_cast<std::size_t>(FeedMessage::COUNT);
+
+    struct Order {
+        unsigned long id;
+        ReadyTraderGo::Side side;
+        unsigned long price;
+        unsigned long remainingVolume;
+        unsigned long filledVolume;
+    };
+
+    struct Hedge {
+        unsigned long id;
+        long volume; // futures bought (positive) or sold (negative)
+    };
+
+    long etfPosition = 0;
+    long futurePosition = 0;
+    unsigned long nextOrderId = 1;
+    std::array<unsigned long, FEED_COUNT> sequences{};
+
+    std::array<Order, MAX_ORDERS> orders{};
+    std::size_t orderCount = 0;
+    std::array<Hedge, MAX_HEDGES> hedges{};
+    std::size_t hedgeCount = 0;
+
+    static std::size_t Feed(ReadyTraderGo::Instrument instrument,
+                            FeedMessage message) {
+        return static_cast<std::size_t>(instrument) *
+                   static_cast<std::size_t>(FeedMessage::COUNT) +
+               static_cast<std::size_t>(message);
+    }
+};
+
+// One change to the JournalState. Every record states a value outright
+// rather than a difference, so replaying a record twice is harmless.
+struct JournalRecord {
+    enum Kind : std::uint8_t { POSITION = 1, ORDER, HEDGE, SEQUENCE, NEXT_ID };
+
+    // Written last: a record only counts once this matches its region.
+    std::uint32_t generation;
+    Kind kind;
+    std::uint8_t side;
+    std::uint16_t reserved;
+    std::uint64_t id;
+    std::int64_t a;
+    std::int64_t b;
+    std::int64_t c;
+};
+
+// A crash-safe journal of the JournalState in a memory-mapped file.
+//
+// Every change is appended as a JournalRecord: a copy into the mapping and
+// no system call, so it is cheap enough for the handlers. The kernel writes
+// the pages out, so the journal survives the process crashing, though not
+// the machine losing power. The file holds two regions; when the active one
+// fills up, a snapshot of the state (a few dozen records) is written to the
+// other, which then becomes active in a single store. A crash at any point
+// leaves one complete region to recover from.
+class StateJournal {
+public:
+    static constexpr std::size_t REGION_RECORDS = 4096;
+
+    // Maps the journal, creating it if it does not exist, and replays it.
+    // Throws std::runtime_error if it cannot be mapped or is not a journal.
+    explicit StateJournal(const std::string &filename);
+
+    StateJournal(const StateJournal &) = delete;
+    StateJournal &operator=(const StateJournal &) = delete;
+
+    // The state replayed from the file, kept up to date by every change.
+    const JournalState &State() const { return mState; }
+
+    // Whether there was anything in the file to replay.
+    bool Recovered() const { return mRecovered; }
+
+    // Drop the state, for a journal left by an earlier match: the next
+    // generation starts out empty.
+    void Clear();
+
+    void Position(long etfPosition, long futurePosition);
+    void Order(unsigned long id, ReadyTraderGo::Side side, unsigned long price,
+               unsigned long remainingVolume, unsigned long filledVolume);
+    void Hedge(unsigned long id, long volume);
+    void Sequence(ReadyTraderGo::Instrument instrument, FeedMessage message,
+                  unsigned long sequenceNumber);
+    void NextOrderId(unsigned long id);
+
+private:
+    struct FileHeader;
+
+    static void Apply(JournalState &state, const JournalRecord &record);
+
+    JournalRecord *Region(std::size_t region);
+    void Append(JournalRecord record);
+    void Write(JournalRecord *slot, std::uint32_t generation,
+               JournalRecord record);
+    // Write the state as a snapshot into the other region and switch to it.
+    void Compact();
+
+    boost::interprocess::mapped_region mRegion;
+    FileHeader *mHeader = nullptr;
+    std::size_t mActive = 0;
+    std::uint32_t mGeneration = 0;
+    std::size_t mUsed = 0;
+
+    JournalState mState;
+    bool mRecovered = false;
+};
+
+#endif // CPPREADY_TRADER_GO_STATEJOURNAL_H
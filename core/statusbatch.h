@@ -0,0 +1,74 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_STATUSBATCH_H
+#define CPPREADY_TRADER_GO_STATUSBATCH_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Order statuses received in one burst, merged per order so that the burst
+// can be applied in a single pass.
+//
+// A status reports the order's cumulative fill and what is left of it,
+// so a later status for the same order supersedes an earlier one: the
+// merged entry keeps the larger fill and the smaller remaining volume, and
+// an order closed by any status of the burst stays closed. The batch is
+// searched linearly; it never holds more than a few dozen orders.
+template <std::size_t Capacity> class StatusBatch {
+public:
+    struct Entry {
+        unsigned long clientOrderId;
+        unsigned long fillVolume;
+        unsigned long remainingVolume;
+    };
+
+    bool Empty() const { return mCount == 0; }
+    bool Full() const { return mCount == Capacity; }
+
+    // Merge a status into the entry for its order, or start one. Returns
+    // false, adding nothing, if it is for a new order and the batch is full.
+    bool Add(unsigned long clientOrderId, unsigned long fillVolume,
+             unsigned long remainingVolume) {
+        for (std::size_t i = 0; i < mCount; i++) {
+            Entry &entry = mEntries[i];
+            if (entry.clientOrderId == clientOrderId) {
+                entry.fillVolume = std::max(entry.fillVolume, fillVolume);
+                entry.remainingVolume =
+                    std::min(entry.remainingVolume, remainingVolume);
+                return true;
+            }
+        }
+        if (mCount == Capacity) {
+            return false;
+        }
+        mEntries[mCount++] = {clientOrderId, fillVolume, remainingVolume};
+        return true;
+    }
+
+    const Entry *begin() const { return mEntries.data(); }
+    const Entry *end() const { return mEntries.data() + mCount; }
+
+    void Clear() { mCount = 0; }
+
+private:
+    std::array<Entry, Capacity> mEntries{};
+    std::size_t mCount = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_STATUSBATCH_H
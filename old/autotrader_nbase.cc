@@ -21,7 +21,7 @@
 
 #include <ready_trader_go/logging.h>
 
-#include "autotrader.h"
+#include "autotrader_nbase.h"
 
 using namespace ReadyTraderGo;
 
@@ -69,11 +69,12 @@ void AutoTrader::OrderBookMessageHandler(Instrument instrument,
                                          const std::array<unsigned long, TOP_LEVEL_COUNT>& bidVolumes)
 {
 	
-	if(sequenceNumber <= mOrderBookSequence) {
+	unsigned long& lastSequence = mOrderBookSequence[static_cast<std::size_t>(instrument)];
+	if(sequenceNumber <= lastSequence) {
 		RLOG(LG_AT, LogLevel::LL_INFO) << "received old order book information.";
 		return;
 	}
-	mOrderBookSequence = sequenceNumber;
+	lastSequence = sequenceNumber;
 	
     RLOG(LG_AT, LogLevel::LL_INFO) << "order book received for " << instrument << " instrument"
                                    << ": ask prices: " << askPrices[0]
@@ -111,7 +111,8 @@ private:
     unsigned long mBidId = 0;
     unsigned long mBidPrice = 0;
     
-	unsigned long mOrderBookSequence = 0;
+	// Last order book sequence number for each instrument
+	std::array<unsigned long, 2> mOrderBookSequence{};
 	
 	// The change in the position we hold if all orders that have left our bot were filled 
 	// either mETFPosition + mETFOrderPositionBuy > 100 or mETFPosition - mETFOrderPositionSell < 100 will disqualify our bot
@@ -15,59 +15,327 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
 
 #include <ready_trader_go/logging.h>
 
+#include "allocationcheck.h"
 #include "autotrader.h"
+#include "exchangeclock.h"
+#include "hotlog.h"
 
 using namespace ReadyTraderGo;
 
 RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_AT, "AUTO")
 
-constexpr int MARGIN_BASIS = 7;
-constexpr int MAX_ORDER_DEPTH = 5;
 constexpr int POSITION_LIMIT = 100;
 constexpr int TICK_SIZE_IN_CENTS = 100;
-constexpr int MIN_BID_NEARST_TICK = (MINIMUM_BID + TICK_SIZE_IN_CENTS) /
-                                    TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
-constexpr int MAX_ASK_NEAREST_TICK =
-    MAXIMUM_ASK / TICK_SIZE_IN_CENTS * TICK_SIZE_IN_CENTS;
 
-Order MAX_ORDER = {MAXIMUM_ASK, 0, 0, false};
-Order MIN_ORDER = {0, 0, 0, false};
+// Futures books between latency reports; at four a second this is about
+// every five minutes.
+constexpr unsigned long LATENCY_REPORT_INTERVAL = 1200;
+
+namespace {
+
+// Future book levels moved by the quote skew; empty levels stay empty.
+std::array<unsigned long, TOP_LEVEL_COUNT>
+SkewLevels(const std::array<unsigned long, TOP_LEVEL_COUNT> &prices,
+           long skew) {
+    std::array<unsigned long, TOP_LEVEL_COUNT> skewed = prices;
+    for (unsigned long &price : skewed) {
+        if (price != 0) {
+            price = static_cast<unsigned long>(
+                std::max<long>(static_cast<long>(price) + skew,
+                               TICK_SIZE_IN_CENTS));
+        }
+    }
+    return skewed;
+}
+
+// Whole ticks between two prices.
+unsigned long TicksBetween(unsigned long a, unsigned long b) {
+    return (a > b ? a - b : b - a) / TICK_SIZE_IN_CENTS;
+}
+
+} // namespace
+
+AutoTrader::AutoTrader(boost::asio::io_context &context,
+                       const StrategyParams &params,
+                       const std::string &marketStateFile)
+    : BaseAutoTrader(context), mParams(params),
+      mThrottle(MessageBudget(), params.throttle),
+      mExecutor(context.get_executor()), mMarket(marketStateFile),
+      mHedges(params.hedgeWindow), mHedgeTimer(context) {
+    mParams.maxOrderDepth = std::clamp<unsigned int>(mParams.maxOrderDepth, 1,
+                                                     ACTIVE_ORDER_COUNT_LIMIT);
+    if (!marketStateFile.empty() && !mMarket.Published()) {
+        RLOG(LG_AT, LogLevel::LL_WARNING)
+            << "could not map " << marketStateFile
+            << "; market state will not be published";
+    }
+    mMetrics.Set(Metric::MESSAGE_LIMIT,
+                 static_cast<std::int64_t>(MessageBudget().limit));
+}
+
+long AutoTrader::OrderVolume(long headroom) const {
+    double c = mParams.volumeCurvature;
+    double shaped =
+        (1.0 - c) * headroom + c * headroom * headroom / (2.0 * POSITION_LIMIT);
+    return static_cast<long>(shaped / mParams.maxOrderDepth);
+}
 
-unsigned long MultiplyBasis(unsigned long n, long basis, bool ceil) {
-    unsigned long d = 10000 + basis;
-    return 100 * ((n * d) / 1000000);
+long AutoTrader::QuoteSkew() const {
+    double cents =
+        mParams.flowSkew * TICK_SIZE_IN_CENTS *
+            mSignals.TradeImbalance(Instrument::FUTURE) +
+        mParams.micropriceSkew * mSignals.MicropriceOffset(Instrument::FUTURE);
+    return std::lround(cents / TICK_SIZE_IN_CENTS) * TICK_SIZE_IN_CENTS;
 }
 
-AutoTrader::AutoTrader(boost::asio::io_context &context)
-    : BaseAutoTrader(context) {}
+void AutoTrader::ReportLatency() {
+    LatencySummaries summaries;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(LatencyProbe::COUNT);
+         i++) {
+        auto probe = static_cast<LatencyProbe>(i);
+        LatencySummary summary = summaries[i] = mLatency.Summary(probe);
+        RLOG(LG_AT, LogLevel::LL_INFO)
+            << "latency " << LatencyProbeName(probe) << ": " << summary.count
+            << " samples; p50 " << static_cast<long>(summary.p50)
+            << "ns; p99 " << static_cast<long>(summary.p99) << "ns; p99.9 "
+            << static_cast<long>(summary.p999) << "ns; max "
+            << static_cast<long>(summary.max) << "ns";
+    }
+    mMetrics.SetLatency(summaries);
+}
+
+void AutoTrader::PublishGauges(std::uint64_t now) {
+    mMetrics.Set(Metric::MESSAGES_IN_WINDOW,
+                 static_cast<std::int64_t>(mScheduler.SentInWindow(now)));
+    mMetrics.Set(Metric::DEFERRED_INTENTS,
+                 static_cast<std::int64_t>(mScheduler.Deferred()));
+    mMetrics.Set(Metric::POSITION, mRisk.Position());
+    mMetrics.Set(Metric::FUTURE_POSITION, mHedges.FuturePosition());
+    mMetrics.Set(Metric::RESTING_ASKS,
+                 static_cast<std::int64_t>(mAsks.orders.Size()));
+    mMetrics.Set(Metric::RESTING_BIDS,
+                 static_cast<std::int64_t>(mBids.orders.Size()));
+    mMetrics.Set(Metric::HEDGES_IN_FLIGHT,
+                 static_cast<std::int64_t>(mHedges.Outstanding()));
+    mMetrics.Set(Metric::HEDGE_SLIPPAGE, mHedges.Slippage());
+}
+
+void AutoTrader::ReportSequences() const {
+    for (Instrument instrument : {Instrument::FUTURE, Instrument::ETF}) {
+        for (FeedMessage message :
+             {FeedMessage::ORDER_BOOK, FeedMessage::TRADE_TICKS}) {
+            const SequenceCounters &counters =
+                mSequences.Counters(instrument, message);
+            RLOG(LG_AT, LogLevel::LL_INFO)
+                << instrument << " " << FeedMessageName(message) << ": "
+                << counters.accepted << " accepted; " << counters.stale
+                << " stale; " << counters.gaps << " gaps skipping "
+                << counters.skipped << " sequence numbers";
+        }
+    }
+}
+
+void AutoTrader::PublishMetricsTo(const std::string &filename) {
+    if (!mMetrics.PublishTo(filename)) {
+        RLOG(LG_AT, LogLevel::LL_WARNING)
+            << "could not map " << filename
+            << "; metrics will not be published";
+    }
+}
+
+void AutoTrader::RecordEventsTo(EventRecorder *recorder) {
+    if (recorder != nullptr && !recorder->IsOpen()) {
+        RLOG(LG_AT, LogLevel::LL_WARNING)
+            << "could not open the event file; callbacks will not be "
+               "recorded";
+    }
+    mEvents = recorder;
+}
+
+void AutoTrader::JournalTo(const std::string &filename) {
+    mJournal = std::make_unique<StateJournal>(filename);
+    mJournalFile = filename;
+    mJournalPending = mJournal->Recovered();
+}
+
+void AutoTrader::ResumeJournal(Instrument instrument, FeedMessage message,
+                               unsigned long sequenceNumber) {
+    mJournalPending = false;
+    // Sequence numbers start again with every match, so a journal from an
+    // earlier one is already ahead of the feed.
+    unsigned long journalled =
+        mJournal->State().sequences[JournalState::Feed(instrument, message)];
+    if (journalled != 0 && sequenceNumber > journalled) {
+        RestoreJournal();
+        return;
+    }
+    RLOG(LG_AT, LogLevel::LL_WARNING)
+        << mJournalFile << " is from an earlier match (" << instrument << " "
+        << FeedMessageName(message) << " " << journalled << ", now at "
+        << sequenceNumber << "); starting afresh";
+    mJournal->Clear();
+}
+
+void AutoTrader::RestoreJournal() {
+    // A copy, as restoring the hedges journals changes to the state.
+    const JournalState state = mJournal->State();
+    mNextMessageId = std::max(mNextMessageId, state.nextOrderId);
+    for (Instrument instrument : {Instrument::FUTURE, Instrument::ETF}) {
+        for (FeedMessage message :
+             {FeedMessage::ORDER_BOOK, FeedMessage::TRADE_TICKS}) {
+            mSequences.Restore(instrument, message,
+                               state.sequences[JournalState::Feed(instrument,
+                                                                  message)]);
+        }
+    }
+
+    mRisk.RestorePosition(state.etfPosition);
+    for (std::size_t i = 0; i < state.orderCount; i++) {
+        const JournalState::Order &order = state.orders[i];
+        Order restored{order.price, order.remainingVolume, order.filledVolume};
+        bool tracked =
+            (order.side == Side::SELL)
+                ? mAsks.orders.Insert(order.id, restored) != nullptr
+                : mBids.orders.Insert(order.id, restored) != nullptr;
+        if (tracked) {
+            mRisk.Inserted(order.side, order.remainingVolume);
+            mRestoredOrders = true;
+        }
+    }
+
+    // No HedgeFilled will come for hedges sent before the restart. They are
+    // fill-and-kill at the limit price, so take them as filled in full.
+    long futurePosition = state.futurePosition;
+    for (std::size_t i = 0; i < state.hedgeCount; i++) {
+        const JournalState::Hedge &hedge = state.hedges[i];
+        RLOG(LG_AT, LogLevel::LL_WARNING)
+            << "hedge order " << hedge.id << " for " << hedge.volume
+            << " lots was in flight when the journal was written; assuming "
+               "it filled";
+        futurePosition += hedge.volume;
+        mJournal->Hedge(hedge.id, 0);
+    }
+    mHedges.Restore(futurePosition);
+    mJournal->Position(state.etfPosition, futurePosition);
+    if (mHedges.Residual(mRisk.Position()) != 0) {
+        // Hedged by the handler of the market data that brought us here.
+        mHedges.Unhedged(ExchangeClockNow());
+    }
+
+    RLOG(LG_AT, LogLevel::LL_INFO)
+        << "restored from " << mJournalFile << ": etf position "
+        << state.etfPosition << "; future position " << futurePosition
+        << "; " << state.orderCount << " orders to cancel; next order id "
+        << mNextMessageId;
+    PublishGauges(ExchangeClockNow());
+}
+
+void AutoTrader::RetireJournal() {
+    if (!mJournal || mJournalPending) {
+        // Never judged against the feed: leave it for the next run to.
+        return;
+    }
+    mJournal.reset();
+    std::string retired = mJournalFile + STATE_JOURNAL_RETIRED_SUFFIX;
+    std::error_code error;
+    std::filesystem::rename(mJournalFile, retired, error);
+    if (error) {
+        RLOG(LG_AT, LogLevel::LL_WARNING)
+            << "could not rename " << mJournalFile << " to " << retired
+            << ": " << error.message()
+            << "; delete it before the next match";
+    }
+}
 
 void AutoTrader::DisconnectHandler() {
+    if (mEvents != nullptr) {
+        mEvents->RecordDisconnect();
+    }
     BaseAutoTrader::DisconnectHandler();
-    RLOG(LG_AT, LogLevel::LL_INFO) << "execution connection lost";
+    ApplyStatuses();
+    DeferredLog::Flush();
+    RLOG(LG_AT, LogLevel::LL_INFO)
+        << "execution connection lost; " << mScheduler.Deferred()
+        << " order messages held back by the message budget; "
+        << mConflatedBooks << " futures books conflated; "
+        << mMetrics.Get(Metric::HELD_REQUOTES)
+        << " requotes held back by the throttle";
+    RLOG(LG_AT, LogLevel::LL_INFO)
+        << "etf position " << mRisk.Position() << "; future position "
+        << mHedges.FuturePosition() << " with " << mHedges.Outstanding()
+        << " hedges in flight";
+    ReportSequences();
+    ReportLatency();
+#ifdef RTG_ALLOCATION_CHECK
+    RLOG(LG_AT, LogLevel::LL_INFO)
+        << HotPathAllocations() << " allocations on the hot path";
+#endif
+    if (mEvents != nullptr && mEvents->Dropped() != 0) {
+        RLOG(LG_AT, LogLevel::LL_WARNING)
+            << "event recorder dropped " << mEvents->Dropped()
+            << " events because the disk fell behind";
+    }
+    RetireJournal();
 }
 
 void AutoTrader::ErrorMessageHandler(unsigned long clientOrderId,
                                      const std::string &errorMessage) {
-    RLOG(LG_AT, LogLevel::LL_INFO)
-        << "error with order " << clientOrderId << ": " << errorMessage;
-    if (clientOrderId != 0 && ((mAsks.count(clientOrderId) == 1) ||
-                               (mBids.count(clientOrderId) == 1))) {
-        OrderStatusMessageHandler(clientOrderId, 0, 0, 0);
+    if (mEvents != nullptr) {
+        mEvents->RecordError(clientOrderId, errorMessage);
     }
+    mMetrics.Add(Metric::ERRORS);
+    HOT_LOG(LG_AT, LogLevel::LL_INFO, "error with order {}: {}", clientOrderId,
+            errorMessage);
+    if (clientOrderId == 0) {
+        return;
+    }
+    // The order is gone; close it without inventing fills. A status never
+    // reduces the fill, so a fill of zero leaves it as it was.
+    QueueStatus(clientOrderId, 0, 0, LatencyNow());
 }
 
 void AutoTrader::HedgeFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long price,
                                            unsigned long volume) {
-    RLOG(LG_AT, LogLevel::LL_INFO)
-        << "hedge order " << clientOrderId << " filled for " << volume
-        << " lots at $" << price << " average price in cents";
+    if (mEvents != nullptr) {
+        mEvents->RecordHedgeFilled(clientOrderId, price, volume);
+    }
+    HOT_LOG(LG_AT, LogLevel::LL_INFO,
+            "hedge order {} filled for {} lots at ${} average price in cents",
+            clientOrderId, volume, price);
+
+    if (ApplyStatuses()) {
+        ScheduleHedge();
+    }
+    if (!mHedges.Filled(clientOrderId, price, volume)) {
+        HOT_LOG(LG_AT, LogLevel::LL_WARNING,
+                "hedge fill for order {} that is not in flight", clientOrderId);
+        return;
+    }
+    mMetrics.Add(Metric::HEDGED_LOTS, static_cast<std::int64_t>(volume));
+    PublishGauges(ExchangeClockNow());
+    if (mJournal) {
+        mJournal->Hedge(clientOrderId, 0);
+        mJournal->Position(mRisk.Position(), mHedges.FuturePosition());
+    }
+
+    // Whatever the hedge did not fill still needs hedging.
+    if (mHedges.Residual(mRisk.Position()) != 0) {
+        mHedges.Unhedged(ExchangeClockNow());
+        ScheduleHedge();
+    }
 }
 
 void AutoTrader::OrderBookMessageHandler(
@@ -76,188 +344,467 @@ void AutoTrader::OrderBookMessageHandler(
     const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
     const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
     const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes) {
+    if (mEvents != nullptr) {
+        mEvents->RecordOrderBook(instrument, sequenceNumber, askPrices,
+                                 askVolumes, bidPrices, bidVolumes);
+    }
+    if (mJournalPending) {
+        ResumeJournal(instrument, FeedMessage::ORDER_BOOK, sequenceNumber);
+    }
 
-    RLOG(LG_AT, LogLevel::LL_INFO)
-        << "order book received for " << instrument << " instrument"
-        << ": ask prices: " << askPrices[0]
-        << "; ask volumes: " << askVolumes[0]
-        << "; bid prices: " << bidPrices[0]
-        << "; bid volumes: " << bidVolumes[0];
+    // Report before starting the clock so the report is not timed.
+    if (instrument == Instrument::FUTURE &&
+        ++mBooksSinceReport == LATENCY_REPORT_INTERVAL) {
+        mBooksSinceReport = 0;
+        ReportLatency();
+    }
 
-    if (instrument != Instrument::FUTURE) {
+    LatencyTimer timer(mLatency, LatencyProbe::BOOK_HANDLER);
+    HotPathScope hotPath;
+    mMetrics.Add(Metric::BOOKS);
+
+    if (mHedges.Pending()) {
+        ScheduleHedge();
+    }
+
+    HOT_LOG(LG_AT, LogLevel::LL_INFO,
+            "order book received for {} instrument: ask prices: {}; ask "
+            "volumes: {}; bid prices: {}; bid volumes: {}",
+            instrument, askPrices[0], askVolumes[0], bidPrices[0],
+            bidVolumes[0]);
+
+    if (!mSequences.Accept(instrument, FeedMessage::ORDER_BOOK,
+                           sequenceNumber)) {
+        HOT_LOG(LG_AT, LogLevel::LL_INFO,
+                "received old order book information.");
+        mMetrics.Add(Metric::STALE_BOOKS);
         return;
     }
+    if (mJournal) {
+        mJournal->Sequence(instrument, FeedMessage::ORDER_BOOK,
+                           sequenceNumber);
+    }
 
-    if (sequenceNumber <= mOrderBookSequence) {
-        RLOG(LG_AT, LogLevel::LL_INFO)
-            << "received old order book information.";
+    unsigned changes = mMarket.Update(instrument, sequenceNumber, askPrices,
+                                      askVolumes, bidPrices, bidVolumes);
+    mSignals.OnOrderBook(instrument, askPrices, askVolumes, bidPrices,
+                         bidVolumes);
+    if (instrument != Instrument::FUTURE) {
         return;
     }
-    mOrderBookSequence = sequenceNumber;
 
-    unsigned long newAskPrice =
-        (askPrices[0] != 0) ? MultiplyBasis(askPrices[0], MARGIN_BASIS, true)
-                            : 0;
-    unsigned long newBidPrice =
-        (bidPrices[0] != 0) ? MultiplyBasis(bidPrices[0], -MARGIN_BASIS, true)
-                            : 0;
+    mThrottle.OnBook(ExchangeClockNow());
+    mPendingChanges |= changes;
+    if (mRepriceScheduled) {
+        mConflatedBooks++;
+        return;
+    }
+    // Book to order latency runs from the oldest book the reprice covers.
+    mBookReceived = timer.Start();
+    mRepriceScheduled = true;
+    boost::asio::post(mExecutor, InArena(mArena, [this] {
+                          mRepriceScheduled = false;
+                          Reprice();
+                      }));
+}
 
-    if (newAskPrice != 0)
-        RepriceSellOrders(newAskPrice);
-    if (newBidPrice != 0)
-        RepriceBuyOrders(newBidPrice);
+template <Side S> void AutoTrader::CancelRestored(QuoteSide<S> &side) {
+    std::uint64_t now = ExchangeClockNow();
+    for (auto &entry : side.orders) {
+        Send({ExecutionRequest::CANCEL, S, Lifespan::GOOD_FOR_DAY, entry.id, 0,
+              0});
+        entry.order.cancelling = true;
+        mScheduler.Count(now);
+    }
 }
 
-void AutoTrader::RepriceSellOrders(unsigned long newAskPrice) {
+void AutoTrader::Reprice() {
+    if (ApplyStatuses()) {
+        ScheduleHedge();
+    }
+    LatencyTimer timer(mLatency, LatencyProbe::REPRICE);
+    HotPathScope hotPath;
+    if (mRestoredOrders) {
+        mRestoredOrders = false;
+        CancelRestored(mAsks);
+        CancelRestored(mBids);
+    }
+    const BookSnapshot &book = mMarket.Current().Book(Instrument::FUTURE);
+    unsigned changes = mPendingChanges;
+    mPendingChanges = BOOK_UNCHANGED;
+
+    // A side only needs repricing if one of its prices moved, the signals
+    // moved the skew, or something happened to our orders on it since it was
+    // last repriced; otherwise the ladder would stage nothing new.
+    long skew = QuoteSkew();
+    bool skewMoved = skew != mQuoteSkew;
+    mQuoteSkew = skew;
+    std::uint64_t now = ExchangeClockNow();
+    bool repriceAsks = WantsReprice(mAsks, book, changes, skewMoved, now);
+    bool repriceBids = WantsReprice(mBids, book, changes, skewMoved, now);
+    if (!repriceAsks && !repriceBids) {
+        return;
+    }
 
-    unsigned long largestOrderId = 0;
-    Order *largestOrder = &MIN_ORDER;
-    bool askAlreadyExists = false;
-    for (auto &[orderId, order] : mAsks) {
-        if (order.cancelling) {
-            continue;
-        }
-        if (order.price == newAskPrice) {
-            askAlreadyExists = true;
-        }
-        if (order.price < newAskPrice) {
-            SendCancelOrder(orderId);
-            order.cancelling = true;
-        } else if (order.price >= largestOrder->price) {
-            largestOrderId = orderId;
-            largestOrder = &order;
-        }
+    mScheduler.Begin(now);
+    if (repriceAsks) {
+        RepriceSide(mAsks, book);
     }
+    if (repriceBids) {
+        RepriceSide(mBids, book);
+    }
+    unsigned long sent = 0;
+    unsigned deferred =
+        mScheduler.Flush([this, &sent](const OrderIntent &intent) {
+            if (intent.side == Side::SELL) {
+                SendIntent(mAsks, intent);
+            } else {
+                SendIntent(mBids, intent);
+            }
+            sent++;
+        });
+
+    // Anything the budget held back has to be staged again next time.
+    mAsks.changed |=
+        (deferred & (1u << static_cast<unsigned>(Side::SELL))) != 0;
+    mBids.changed |=
+        (deferred & (1u << static_cast<unsigned>(Side::BUY))) != 0;
+
+    mThrottle.OnReprice(now, sent,
+                        static_cast<double>(LatencyNow() - timer.Start()) *
+                            mLatency.NanosecondsPerTick());
+    PublishGauges(now);
+}
 
-    if (largestOrderId != 0 && !largestOrder->cancelling &&
-        mETFOrderAskCount >= MAX_ORDER_DEPTH - 1) {
-        RLOG(LG_AT, LogLevel::LL_INFO)
-            << "cancelling sell order " << largestOrderId << " @ "
-            << largestOrder->price << " to make room for other orders";
-        largestOrder->cancelling = true;
-        SendCancelOrder(largestOrderId);
+template <Side S>
+bool AutoTrader::WantsReprice(QuoteSide<S> &side, const BookSnapshot &book,
+                              unsigned changes, bool skewMoved,
+                              std::uint64_t now) {
+    using Traits = SideTraits<S>;
+    unsigned long best = Traits::Prices(book)[0];
+    if (best == 0 ||
+        !(side.changed || skewMoved || (changes & Traits::PRICE_CHANGES))) {
+        return false;
     }
+    // A side the throttle holds back is remembered as changed, so the next
+    // book requotes it.
+    if (!mThrottle.Allow(now, TicksBetween(best + mQuoteSkew, side.quoted))) {
+        side.changed = true;
+        mMetrics.Add(Metric::HELD_REQUOTES);
+        return false;
+    }
+    return true;
+}
 
-    // TODO: maybe theres a quadratic function for this
-    long orderVolume = (mETFPosition + POSITION_LIMIT) / MAX_ORDER_DEPTH;
+template <Side S>
+void AutoTrader::RepriceSide(QuoteSide<S> &side, const BookSnapshot &book) {
+    using Traits = SideTraits<S>;
+    const BookSnapshot::Levels &references = Traits::Prices(book);
+    // How far a full fill on this side could move the position before it
+    // reached the limit.
+    long headroom = POSITION_LIMIT - Traits::DIRECTION * mRisk.Position();
+    side.ladder.template SetTargets<TICK_SIZE_IN_CENTS>(
+        SkewLevels(references, mQuoteSkew), mParams.maxOrderDepth,
+        mParams.marginBasis, OrderVolume(headroom));
+    side.ladder.Plan(side.orders, mParams.maxOrderDepth, mRisk.InsertRoom(S),
+                     mScheduler);
+    side.changed = false;
+    side.quoted = references[0] + mQuoteSkew;
+}
 
-    if (askAlreadyExists ||
-        (mETFPosition - mETFOrderPositionSell - orderVolume) <
-            -POSITION_LIMIT ||
-        mETFOrderAskCount >= MAX_ORDER_DEPTH) {
+void AutoTrader::Send(const ExecutionRequest &request) {
+    if (mBridge != nullptr) {
+        mBridge->Request(request);
         return;
     }
-
-    auto orderId = mNextMessageId++;
-    SendInsertOrder(orderId, Side::SELL, newAskPrice, orderVolume,
-                    Lifespan::GOOD_FOR_DAY);
-
-    mETFOrderAskCount++;
-    mETFOrderPositionSell += orderVolume;
-
-    mAsks[orderId] = {newAskPrice, (unsigned long)orderVolume, 0};
+    switch (request.type) {
+    case ExecutionRequest::AMEND:
+        SendAmendOrder(request.clientOrderId, request.volume);
+        break;
+    case ExecutionRequest::CANCEL:
+        SendCancelOrder(request.clientOrderId);
+        break;
+    case ExecutionRequest::HEDGE:
+        SendHedgeOrder(request.clientOrderId, request.side, request.price,
+                       request.volume);
+        break;
+    case ExecutionRequest::INSERT:
+        SendInsertOrder(request.clientOrderId, request.side, request.price,
+                        request.volume, request.lifespan);
+        break;
+    }
 }
 
-void AutoTrader::RepriceBuyOrders(unsigned long newBidPrice) {
+template <Side S>
+void AutoTrader::SendIntent(QuoteSide<S> &side, const OrderIntent &intent) {
+    Order *order = nullptr;
+    if (intent.kind != OrderIntent::INSERT) {
+        order = side.orders.Find(intent.orderId);
+    }
 
-    unsigned long smallestOrderId = 0;
-    Order *smallestOrder = &MAX_ORDER;
-    bool bidAlreadyExists = false;
-    for (auto &[orderId, order] : mBids) {
-        if (order.cancelling) {
-            continue;
+    if (intent.kind == OrderIntent::AMEND) {
+        unsigned long current =
+            order->amendVolume != 0
+                ? order->amendVolume
+                : order->filledVolume + order->remainingVolume;
+        if (!mRisk.AllowAmend(order->filledVolume, current, intent.volume)) {
+            HOT_LOG(LG_AT, LogLevel::LL_WARNING,
+                    "risk gate refused amend of {} order {} to {} lots", S,
+                    intent.orderId, intent.volume);
+            return;
         }
-        if (order.price == newBidPrice) {
-            bidAlreadyExists = true;
-        }
-        if (order.price > newBidPrice) {
-            SendCancelOrder(orderId);
-            order.cancelling = true;
-        } else if (order.price <= smallestOrder->price) {
-            smallestOrderId = orderId;
-            smallestOrder = &order;
+        Send({ExecutionRequest::AMEND, S, Lifespan::GOOD_FOR_DAY,
+              intent.orderId, 0, intent.volume});
+        mLatency.Record(LatencyProbe::BOOK_TO_ORDER, mBookReceived);
+        mMetrics.Add(Metric::AMENDS);
+        order->amendVolume = intent.volume;
+        return;
+    }
+
+    if (intent.kind == OrderIntent::CANCEL) {
+        if (intent.urgency == OrderIntent::SPARE) {
+            HOT_LOG(LG_AT, LogLevel::LL_INFO,
+                    "cancelling {} order {} @ {} that is off the ladder", S,
+                    intent.orderId, intent.price);
         }
+        Send({ExecutionRequest::CANCEL, S, Lifespan::GOOD_FOR_DAY,
+              intent.orderId, 0, 0});
+        mLatency.Record(LatencyProbe::BOOK_TO_ORDER, mBookReceived);
+        mMetrics.Add(Metric::CANCELS);
+        order->cancelling = true;
+        return;
     }
 
-    if (smallestOrderId != 0 && !smallestOrder->cancelling &&
-        mETFOrderBidCount >= MAX_ORDER_DEPTH - 1) {
-        smallestOrder->cancelling = true;
-        SendCancelOrder(smallestOrderId);
+    if (!mRisk.AllowInsert(S, intent.volume)) {
+        HOT_LOG(LG_AT, LogLevel::LL_WARNING,
+                "risk gate refused {} insert of {} lots @ {}; position {}, "
+                "active volume {}, active orders {}",
+                S, intent.volume, intent.price, mRisk.Position(),
+                mRisk.ActiveVolume(), mRisk.ActiveOrders());
+        return;
     }
+    auto orderId = mNextMessageId++;
+    Send({ExecutionRequest::INSERT, S, Lifespan::GOOD_FOR_DAY, orderId,
+          intent.price, intent.volume});
+    mLatency.Record(LatencyProbe::BOOK_TO_ORDER, mBookReceived);
+    mMetrics.Add(Metric::INSERTS);
+
+    mRisk.Inserted(S, intent.volume);
+    if (mJournal) {
+        mJournal->Order(orderId, S, intent.price, intent.volume, 0);
+    }
+    side.orders.Insert(orderId, {intent.price, intent.volume, 0});
+}
 
-    long orderVolume = (POSITION_LIMIT - mETFPosition) / MAX_ORDER_DEPTH;
+void AutoTrader::ScheduleHedge() {
+    if (mHedgeScheduled) {
+        return;
+    }
+    mHedgeScheduled = true;
+    boost::asio::post(mExecutor, InArena(mArena, [this] {
+                          mHedgeScheduled = false;
+                          SendHedge();
+                      }));
+}
 
-    if (bidAlreadyExists ||
-        (mETFPosition + mETFOrderPositionBuy + orderVolume) > POSITION_LIMIT ||
-        mETFOrderBidCount >= MAX_ORDER_DEPTH) {
+void AutoTrader::SendHedge() {
+    ApplyStatuses();
+    HotPathScope hotPath;
+    std::uint64_t now = ExchangeClockNow();
+    if (!mHedges.Pending()) {
+        return;
+    }
+    if (!mHedges.Due(now)) {
+        // The timer covers a quiet market; otherwise the next message
+        // schedules another check anyway.
+        mHedgeTimer.expires_after(
+            std::chrono::nanoseconds(mHedges.Deadline() - now));
+        mHedgeTimer.async_wait(
+            InArena(mArena, [this](const boost::system::error_code &error) {
+                if (!error) {
+                    SendHedge();
+                }
+            }));
         return;
     }
 
-    auto orderId = mNextMessageId++;
-    SendInsertOrder(orderId, Side::BUY, newBidPrice, orderVolume,
-                    Lifespan::GOOD_FOR_DAY);
+    long residual = mHedges.Residual(mRisk.Position());
+    if (residual == 0) {
+        mHedges.Hedged();
+        return;
+    }
 
-    mETFOrderBidCount++;
-    mETFOrderPositionBuy += orderVolume;
-    mBids[orderId] = {newBidPrice, (unsigned long)orderVolume, 0};
+    // If too many hedges are in flight this stays pending until one of
+    // them reports back.
+    long futurePosition = -mRisk.Position() - residual;
+    if (!mRisk.AllowHedge(futurePosition, residual)) {
+        HOT_LOG(LG_AT, LogLevel::LL_WARNING,
+                "risk gate refused hedge of {} lots with future position {}",
+                residual, futurePosition);
+        mHedges.Hedged();
+        return;
+    }
+
+    // Slippage is measured against the best price the hedge could trade
+    // at when it was sent.
+    const BookSnapshot &future = mMarket.Current().Book(Instrument::FUTURE);
+    unsigned long orderId = mNextMessageId;
+    if (!mHedges.Sent(orderId, residual,
+                      residual > 0 ? future.askPrices[0]
+                                   : future.bidPrices[0])) {
+        return;
+    }
+    mNextMessageId++;
+    if (mJournal) {
+        mJournal->Hedge(orderId, residual);
+    }
+    Send({ExecutionRequest::HEDGE, residual > 0 ? Side::BUY : Side::SELL,
+          Lifespan::FILL_AND_KILL, orderId,
+          residual > 0
+              ? SideTraits<Side::BUY>::MARKETABLE_PRICE<TICK_SIZE_IN_CENTS>
+              : SideTraits<Side::SELL>::MARKETABLE_PRICE<TICK_SIZE_IN_CENTS>,
+          static_cast<unsigned long>(std::labs(residual))});
+    mLatency.Record(LatencyProbe::STATUS_TO_HEDGE, mFirstUnhedgedFill);
+    mScheduler.Count(now);
+    mMetrics.Add(Metric::HEDGES);
+    PublishGauges(now);
 }
 
 void AutoTrader::OrderFilledMessageHandler(unsigned long clientOrderId,
                                            unsigned long price,
                                            unsigned long volume) {
-    RLOG(LG_AT, LogLevel::LL_INFO) << "order filled message " << clientOrderId
-                                   << " " << price << " " << volume;
+    if (mEvents != nullptr) {
+        mEvents->RecordOrderFilled(clientOrderId, price, volume);
+    }
+    HOT_LOG(LG_AT, LogLevel::LL_INFO, "order filled message {} {} {}",
+            clientOrderId, price, volume);
 }
 
 void AutoTrader::OrderStatusMessageHandler(unsigned long clientOrderId,
                                            unsigned long fillVolume,
                                            unsigned long remainingVolume,
                                            signed long fees) {
+    if (mEvents != nullptr) {
+        mEvents->RecordOrderStatus(clientOrderId, fillVolume, remainingVolume,
+                                   fees);
+    }
+    LatencyTimer timer(mLatency, LatencyProbe::STATUS_HANDLER);
+    HotPathScope hotPath;
 
-    RLOG(LG_AT, LogLevel::LL_INFO)
-        << "order status message received " << clientOrderId << " "
-        << fillVolume << " " << remainingVolume << " " << fees;
+    HOT_LOG(LG_AT, LogLevel::LL_INFO,
+            "order status message received {} {} {} {}", clientOrderId,
+            fillVolume, remainingVolume, fees);
 
-    bool isSellOrder = mAsks.count(clientOrderId);
-    if (!isSellOrder && !mBids.count(clientOrderId)) {
-        RLOG(LG_AT, LogLevel::LL_INFO)
-            << "received order status for order we are not tracking. "
-               "id="
-            << clientOrderId;
+    QueueStatus(clientOrderId, fillVolume, remainingVolume, timer.Start());
+}
+
+void AutoTrader::QueueStatus(unsigned long clientOrderId,
+                             unsigned long fillVolume,
+                             unsigned long remainingVolume,
+                             LatencyTicks received) {
+    if (!mStatuses.Add(clientOrderId, fillVolume, remainingVolume)) {
+        if (ApplyStatuses()) {
+            ScheduleHedge();
+        }
+        mStatuses.Add(clientOrderId, fillVolume, remainingVolume);
+    }
+    // Statuses without fills only change what the next reprice sees, and
+    // it applies the batch first; fills have to be hedged.
+    if (fillVolume == 0 || mStatusesFilled) {
         return;
     }
+    mStatusesFilled = true;
+    mStatusesReceived = received;
+    mStatusesSince = ExchangeClockNow();
+    // A queued reprice or hedge applies the batch before anything else.
+    if (mStatusesScheduled || mRepriceScheduled || mHedgeScheduled) {
+        return;
+    }
+    mStatusesScheduled = true;
+    boost::asio::post(mExecutor, InArena(mArena, [this] {
+                          mStatusesScheduled = false;
+                          // The messages queued behind the first status
+                          // are handled, so the hedge need not wait again.
+                          if (ApplyStatuses() && !mHedgeScheduled) {
+                              SendHedge();
+                          }
+                      }));
+}
 
-    auto &sideMap = isSellOrder ? mAsks : mBids;
-    Order &order = sideMap[clientOrderId];
+bool AutoTrader::ApplyStatuses() {
+    if (mStatuses.Empty()) {
+        return false;
+    }
+    LatencyTimer timer(mLatency, LatencyProbe::STATUS_BATCH);
+    HotPathScope hotPath;
+
+    long filled = 0;
+    for (const auto &status : mStatuses) {
+        if (Order *order = mAsks.orders.Find(status.clientOrderId)) {
+            filled += UpdateOrder(mAsks, status.clientOrderId, *order,
+                                  status.fillVolume, status.remainingVolume);
+        } else if (Order *order = mBids.orders.Find(status.clientOrderId)) {
+            filled += UpdateOrder(mBids, status.clientOrderId, *order,
+                                  status.fillVolume, status.remainingVolume);
+        } else {
+            HOT_LOG(LG_AT, LogLevel::LL_INFO,
+                    "received order status for order we are not tracking. "
+                    "id={}",
+                    status.clientOrderId);
+        }
+    }
+    mStatuses.Clear();
+    mStatusesFilled = false;
+    mMetrics.Add(Metric::FILLED_LOTS, filled);
+    PublishGauges(ExchangeClockNow());
+    if (filled == 0) {
+        return false;
+    }
 
     // Update our futures position to make sure we are correctly hedged
-    auto dFilled = fillVolume - order.filledVolume;
-    if (dFilled > 0) {
-        mETFPosition += isSellOrder ? -dFilled : dFilled;
-        SendHedgeOrder(mNextMessageId++, isSellOrder ? Side::BUY : Side::SELL,
-                       isSellOrder ? MAX_ASK_NEAREST_TICK : MIN_BID_NEARST_TICK,
-                       dFilled);
-    }
-
-    // Update the state
-    auto dRemaining = order.remainingVolume - remainingVolume;
-    if (isSellOrder) {
-        mETFOrderPositionSell -= dRemaining;
-    } else {
-        mETFOrderPositionBuy -= dRemaining;
+    if (mJournal) {
+        mJournal->Position(mRisk.Position(), mHedges.FuturePosition());
+    }
+    // The position sizes the orders on both sides.
+    mAsks.changed = mBids.changed = true;
+    if (!mHedges.Pending()) {
+        mFirstUnhedgedFill = mStatusesReceived;
+    }
+    mHedges.Unhedged(mStatusesSince);
+    return true;
+}
+
+template <Side S>
+long AutoTrader::UpdateOrder(QuoteSide<S> &side, unsigned long clientOrderId,
+                             Order &order, unsigned long fillVolume,
+                             unsigned long remainingVolume) {
+    side.changed = true;
+
+    // Both volumes are unsigned, so take the differences as signed values
+    // and never let a late or repeated status move them backwards.
+    long dFilled = std::max(0L, static_cast<long>(fillVolume) -
+                                    static_cast<long>(order.filledVolume));
+    long dRemaining =
+        std::max(0L, static_cast<long>(order.remainingVolume) -
+                         static_cast<long>(remainingVolume));
+    mRisk.Updated(S, dFilled, dRemaining, remainingVolume == 0);
+    fillVolume = std::max(fillVolume, order.filledVolume);
+    remainingVolume = std::min(remainingVolume, order.remainingVolume);
+    if (mJournal) {
+        mJournal->Order(clientOrderId, S, order.price, remainingVolume,
+                        fillVolume);
     }
 
     if (remainingVolume > 0) {
         order.remainingVolume = remainingVolume;
         order.filledVolume = fillVolume;
-    } else {
-        if (isSellOrder) {
-            mETFOrderAskCount--;
-        } else {
-            mETFOrderBidCount--;
+        if (fillVolume + remainingVolume <= order.amendVolume) {
+            order.amendVolume = 0;
         }
-        sideMap.erase(clientOrderId);
+    } else {
+        side.orders.Erase(clientOrderId);
     }
+    return dFilled;
 }
 
 void AutoTrader::TradeTicksMessageHandler(
@@ -266,10 +813,34 @@ void AutoTrader::TradeTicksMessageHandler(
     const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
     const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
     const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes) {
-    RLOG(LG_AT, LogLevel::LL_INFO)
-        << "trade ticks received for " << instrument << " instrument"
-        << ": ask prices: " << askPrices[0]
-        << "; ask volumes: " << askVolumes[0]
-        << "; bid prices: " << bidPrices[0]
-        << "; bid volumes: " << bidVolumes[0];
+    if (mEvents != nullptr) {
+        mEvents->RecordTradeTicks(instrument, sequenceNumber, askPrices,
+                                  askVolumes, bidPrices, bidVolumes);
+    }
+    if (mJournalPending) {
+        ResumeJournal(instrument, FeedMessage::TRADE_TICKS, sequenceNumber);
+    }
+    LatencyTimer timer(mLatency, LatencyProbe::TICKS_HANDLER);
+    HotPathScope hotPath;
+    if (mHedges.Pending()) {
+        ScheduleHedge();
+    }
+    HOT_LOG(LG_AT, LogLevel::LL_INFO,
+            "trade ticks received for {} instrument: ask prices: {}; ask "
+            "volumes: {}; bid prices: {}; bid volumes: {}",
+            instrument, askPrices[0], askVolumes[0], bidPrices[0],
+            bidVolumes[0]);
+    if (!mSequences.Accept(instrument, FeedMessage::TRADE_TICKS,
+                           sequenceNumber)) {
+        HOT_LOG(LG_AT, LogLevel::LL_INFO,
+                "received old trade ticks information.");
+        mMetrics.Add(Metric::STALE_TICKS);
+        return;
+    }
+    if (mJournal) {
+        mJournal->Sequence(instrument, FeedMessage::TRADE_TICKS,
+                           sequenceNumber);
+    }
+    mSignals.OnTradeTicks(instrument, askPrices, askVolumes, bidPrices,
+                          bidVolumes);
 }
@@ -19,28 +19,135 @@
 #define CPPREADY_TRADER_GO_AUTOTRADER_H
 
 #include <array>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
-#include <unordered_set>
 
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
 
 #include <ready_trader_go/baseautotrader.h>
 #include <ready_trader_go/types.h>
 
-struct Order {
+#include "eventrecorder.h"
+#include "hedgeaggregator.h"
+#include "iobridge.h"
+#include "latency.h"
+#include "marketstate.h"
+#include "messagescheduler.h"
+#include "metrics.h"
+#include "orderslab.h"
+#include "quoteladder.h"
+#include "quotethrottle.h"
+#include "riskgate.h"
+#include "sessionarena.h"
+#include "sequencetracker.h"
+#include "sidetraits.h"
+#include "signals.h"
+#include "statejournal.h"
+#include "statusbatch.h"
 
-    unsigned long price;
+// The exchange will not accept more active orders than this, so it bounds how
+// many orders we can ever be tracking on one side.
+constexpr std::size_t ACTIVE_ORDER_COUNT_LIMIT = 10;
 
-    unsigned long remainingVolume;
-    unsigned long filledVolume;
+// Orders are kept best first, so asks from the lowest price and bids from
+// the highest, and the best order on either side is always at the front.
+template <ReadyTraderGo::Side S>
+using SideSlab =
+    OrderSlab<ACTIVE_ORDER_COUNT_LIMIT, typename SideTraits<S>::Better>;
+using AskSlab = SideSlab<ReadyTraderGo::Side::SELL>;
+using BidSlab = SideSlab<ReadyTraderGo::Side::BUY>;
 
-    bool cancelling = false;
+// Orders on both sides, with room for statuses for ids we are not tracking,
+// so a burst of statuses is almost never applied in more than one pass.
+constexpr std::size_t STATUS_BATCH_CAPACITY = 4 * ACTIVE_ORDER_COUNT_LIMIT;
+
+// Our orders and quotes on one side of the ETF book.
+template <ReadyTraderGo::Side S> struct QuoteSide {
+    static constexpr ReadyTraderGo::Side SIDE = S;
+
+    SideSlab<S> orders;
+
+    // The quotes we want.
+    QuoteLadder<S> ladder;
+
+    // Whether an order status (or an intent the scheduler or the throttle
+    // held back) has touched our orders since the side was last repriced.
+    bool changed = true;
+
+    // The skewed best future price the side was last quoted off.
+    unsigned long quoted = 0;
+};
+
+// Where the autotrader publishes its MarketState for other processes.
+constexpr char MARKET_STATE_FILENAME[] = "market_state.dat";
+
+// Tunable parameters of the strategy. The defaults are what we trade with.
+struct StrategyParams {
+    // How far outside the future's best prices we quote, in basis points.
+    long marginBasis = 7;
+
+    // The most orders we keep resting on each side; clamped to
+    // [1, ACTIVE_ORDER_COUNT_LIMIT]. We quote one order at each of this many
+    // levels of the future book, up to TOP_LEVEL_COUNT.
+    unsigned int maxOrderDepth = 5;
+
+    // Shape of the order size as a function of the position headroom on that
+    // side. Zero splits the headroom evenly over maxOrderDepth orders; values
+    // towards one shrink orders quadratically as the headroom runs out.
+    double volumeCurvature = 0.0;
+
+    // How long, in nanoseconds, fills are netted before they are hedged.
+    // Zero hedges as soon as the messages already received are handled.
+    std::uint64_t hedgeWindow = 0;
+
+    // Ticks both ladders move towards the side the future is trading on, per
+    // unit of its averaged trade imbalance.
+    double flowSkew = 0.0;
+
+    // Share of the future's microprice offset from its mid that both ladders
+    // move by.
+    double micropriceSkew = 0.0;
+
+    // How the re-quote interval and price tolerance adapt to the book rate,
+    // the messages each requote sends and how long repricing takes.
+    QuoteThrottleParams throttle;
 };
 
 class AutoTrader : public ReadyTraderGo::BaseAutoTrader {
 public:
-    explicit AutoTrader(boost::asio::io_context &context);
+    // An empty marketStateFile keeps the market state private, as the
+    // backtests do so that parallel runs do not share one file.
+    explicit AutoTrader(
+        boost::asio::io_context &context,
+        const StrategyParams &params = StrategyParams(),
+        const std::string &marketStateFile = MARKET_STATE_FILENAME);
+
+    // Send every request through the bridge's I/O thread instead of this
+    // trader's own connection, for running on a TradingThread.
+    void RelayOrdersTo(IoBridge *bridge) { mBridge = bridge; }
+
+    // Journal the positions, orders and hedges to the given file. Whatever
+    // state an earlier run left in it is taken up when the first book or
+    // ticks arrive, if their sequence number shows the match is the one the
+    // journal was written in; otherwise the journal starts out empty.
+    // Orders restored from the journal are cancelled on the first reprice,
+    // and their status replies bring in any fills they had in the meantime.
+    // After a disconnect the journal is renamed with
+    // STATE_JOURNAL_RETIRED_SUFFIX, so the next match starts afresh. Throws
+    // std::runtime_error if the file cannot be used as a journal.
+    void JournalTo(const std::string &filename);
+
+    // Record every callback, before it is handled, for replaying later
+    // with event_replay. The recorder must outlive the trader; a warning is
+    // logged if it could not open its file.
+    void RecordEventsTo(EventRecorder *recorder);
+
+    // Publish the metrics to the given file for other processes to watch
+    // (see metrics.h); if it cannot be mapped they stay private.
+    void PublishMetricsTo(const std::string &filename);
 
     // Called when the execution connection is lost.
     void DisconnectHandler() override;
@@ -78,9 +185,6 @@ public:
         const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
             &bidVolumes) override;
 
-    void RepriceBuyOrders(unsigned long newBidPrice);
-    void RepriceSellOrders(unsigned long newAskPrice);
-
     // Called when one of your orders is filled, partially or fully.
     void OrderFilledMessageHandler(unsigned long clientOrderId,
                                    unsigned long price,
@@ -114,23 +218,146 @@ public:
             &bidVolumes) override;
 
 private:
+    // Volume of the next order given how many lots we could still trade on
+    // that side before reaching the position limit.
+    long OrderVolume(long headroom) const;
+
+    // Log a latency summary for every probe, and publish them with the
+    // metrics.
+    void ReportLatency();
+
+    // Bring the metrics' gauges up to date with our orders and positions.
+    void PublishGauges(std::uint64_t now);
+
+    // Log the sequence counters of every feed.
+    void ReportSequences() const;
+
+    // How far, in cents and whole ticks, the signals move our quotes.
+    long QuoteSkew() const;
+
+    // Decide, on the first market data, whether the journal belongs to this
+    // match, and restore it or clear it.
+    void ResumeJournal(ReadyTraderGo::Instrument instrument,
+                       FeedMessage message, unsigned long sequenceNumber);
+
+    // Take up the state an earlier run of this match journalled.
+    void RestoreJournal();
+
+    // Close the journal and set it aside once the match is over.
+    void RetireJournal();
+
+    // Cancel the orders restored from the journal on one side.
+    template <ReadyTraderGo::Side S> void CancelRestored(QuoteSide<S> &side);
+
+    // Reprice both sides off the newest futures book, once for however many
+    // books arrived since the last time.
+    void Reprice();
+
+    // Whether a side needs repricing off the book, and the throttle lets it.
+    template <ReadyTraderGo::Side S>
+    bool WantsReprice(QuoteSide<S> &side, const BookSnapshot &book,
+                      unsigned changes, bool skewMoved, std::uint64_t now);
+
+    // Stage whatever moves a side to the ladder quoted off the future book.
+    template <ReadyTraderGo::Side S>
+    void RepriceSide(QuoteSide<S> &side, const BookSnapshot &book);
+
+    // Hand a request to the bridge, or send it ourselves if there is none.
+    void Send(const ExecutionRequest &request);
+
+    // Send an intent the scheduler let through and start tracking it.
+    template <ReadyTraderGo::Side S>
+    void SendIntent(QuoteSide<S> &side, const OrderIntent &intent);
+
+    // Buffer an order status to be applied with the rest of its burst.
+    void QueueStatus(unsigned long clientOrderId, unsigned long fillVolume,
+                     unsigned long remainingVolume, LatencyTicks received);
+
+    // Apply every buffered status in one pass: each order is looked up and
+    // journalled once, and their fills make a single hedge decision.
+    // Whatever reads our orders or position calls this first. Returns
+    // whether there were fills, which the caller has to see hedged.
+    bool ApplyStatuses();
+
+    // Account for the status of one of our orders on a side. Returns the
+    // lots it newly filled.
+    template <ReadyTraderGo::Side S>
+    long UpdateOrder(QuoteSide<S> &side, unsigned long clientOrderId,
+                     Order &order, unsigned long fillVolume,
+                     unsigned long remainingVolume);
+
+    // Arrange for SendHedge to run once the queued messages are handled.
+    void ScheduleHedge();
+
+    // Hedge the residual position if the netting window has closed, or
+    // wait for it to close.
+    void SendHedge();
+
+    StrategyParams mParams;
+
+    IoBridge *mBridge = nullptr;
+
+    EventRecorder *mEvents = nullptr;
+
+    // Where every change to our state is journalled, if anywhere.
+    std::unique_ptr<StateJournal> mJournal;
+    std::string mJournalFile;
+    // Whether the journal holds an earlier run's state, not yet restored or
+    // cleared.
+    bool mJournalPending = false;
+    bool mRestoredOrders = false;
+
+    LatencyMonitor mLatency;
+    Metrics mMetrics;
+    LatencyTicks mBookReceived = 0;
+    unsigned long mBooksSinceReport = 0;
+
+    MessageScheduler mScheduler;
+
+    // Holds back requotes the message budget cannot keep up with.
+    QuoteThrottle mThrottle;
+
+    // Books are conflated: the handler only records the newest one and posts
+    // a single Reprice for everything that arrived before it runs.
+    boost::asio::io_context::executor_type mExecutor;
+    std::shared_ptr<SessionArena> mArena = std::make_shared<SessionArena>();
+    bool mRepriceScheduled = false;
+    unsigned mPendingChanges = BOOK_UNCHANGED;
+    unsigned long mConflatedBooks = 0;
+
     unsigned long mNextMessageId = 1;
-    unsigned long mOrderBookSequence = 0;
 
-    // The change in the position we hold if all orders that have left our bot
-    // were filled either mETFPosition + mETFOrderPositionBuy > 100 or
-    // mETFPosition - mETFOrderPositionSell < 100 will disqualify our bot
-    signed long mETFOrderPositionSell = 0;
-    signed long mETFOrderPositionBuy = 0;
+    // Newest sequence number of each feed; anything older is dropped.
+    SequenceTracker mSequences;
+
+    // Latest books of both instruments and the basis between them.
+    MarketState mMarket;
+
+    // Trade flow and book signals, and the skew the ladders were last
+    // quoted with.
+    MarketSignals mSignals;
+    long mQuoteSkew = 0;
+
+    // The ETF position, our resting volume and order count, and the checks
+    // every order goes through against the exchange's limits.
+    RiskGate mRisk;
 
-    unsigned int mETFOrderAskCount = 0;
-    unsigned int mETFOrderBidCount = 0;
+    HedgeAggregator mHedges;
+    boost::asio::steady_timer mHedgeTimer;
+    bool mHedgeScheduled = false;
+    LatencyTicks mFirstUnhedgedFill = 0;
 
-    signed long mETFPosition = 0;
+    // Statuses and errors received since the last ApplyStatuses, and when
+    // the first of them with a fill arrived.
+    StatusBatch<STATUS_BATCH_CAPACITY> mStatuses;
+    bool mStatusesScheduled = false;
+    bool mStatusesFilled = false;
+    LatencyTicks mStatusesReceived = 0;
+    std::uint64_t mStatusesSince = 0;
 
-    // We track the state of our orders that are currently in the market
-    std::unordered_map<unsigned long, Order> mAsks;
-    std::unordered_map<unsigned long, Order> mBids;
+    // The orders we have in the market, and the quotes we want, per side.
+    QuoteSide<ReadyTraderGo::Side::SELL> mAsks;
+    QuoteSide<ReadyTraderGo::Side::BUY> mBids;
 };
 
 #endif // CPPREADY_TRADER_GO_AUTOTRADER_H
@@ -0,0 +1,92 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+
+#include "allocationcheck.h"
+#include "autotrader.h"
+#include "replay.h"
+#include "simexchange.h"
+
+static void PrintResult(const SimResult &result) {
+    std::cout << "profit (cents):          " << result.profit << '\n'
+              << "fees (cents):            " << result.fees << '\n'
+              << "etf position:            " << result.etfPosition << '\n'
+              << "future position:         " << result.futurePosition << '\n'
+              << "max |etf position|:      " << result.maxAbsEtfPosition
+              << '\n'
+              << "etf traded volume:       " << result.etfTradedVolume << '\n'
+              << "fills / hedges / errors: " << result.fills << " / "
+              << result.hedges << " / " << result.errors << '\n'
+              << "messages:                " << result.messages << '\n'
+              << "max messages/interval:   " << result.maxMessagesPerInterval
+              << '\n';
+    if (result.positionLimitBreached) {
+        std::cout << "BREACH: position limit\n";
+    }
+    if (result.messageLimitBreached) {
+        std::cout << "BREACH: message frequency limit\n";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 && argc != 3) {
+        std::cerr << "usage: " << argv[0] << " CAPTURE_PREFIX [EXCHANGE_JSON]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SimExchangeConfig config;
+    if (argc == 3 && !LoadSimExchangeConfig(argv[2], config)) {
+        std::cerr << "could not read " << argv[2] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Formatting log records would dominate the run time.
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try {
+        ReplaySession session(argv[1]);
+
+        boost::asio::io_context context;
+        AutoTrader trader(context, StrategyParams(), "");
+
+        auto start = std::chrono::steady_clock::now();
+        SimResult result = session.Run(trader, config, context);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        PrintResult(result);
+        std::cout << "replayed " << session.Size() << " events in "
+                  << elapsed.count() << "s" << std::endl;
+#ifdef RTG_ALLOCATION_CHECK
+        std::cout << "hot path allocations:    " << HotPathAllocations()
+                  << std::endl;
+#endif
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
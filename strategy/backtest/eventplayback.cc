@@ -0,0 +1,167 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include <chrono>
+#include <thread>
+
+#include "eventplayback.h"
+#include "exchangeclock.h"
+
+using namespace ReadyTraderGo;
+
+// Playback runs on a single thread, like the backtest.
+static std::uint64_t gPlaybackTime = 0;
+
+std::uint64_t ExchangeClockNow() { return gPlaybackTime; }
+
+static const char *SideName(Side side) {
+    return (side == Side::BUY) ? "buy" : "sell";
+}
+
+EventPlayback::EventPlayback(BaseAutoTrader &trader, std::ostream *requestLog)
+    : mTrader(trader), mRequestLog(requestLog) {
+    mTrader.SetExecutionSink(this);
+}
+
+void EventPlayback::Run(const EventReader &events,
+                        boost::asio::io_context &context, double speed) {
+    if (events.Size() == 0) {
+        return;
+    }
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    std::uint64_t first = events[0].received;
+
+    for (const EventRecord &event : events) {
+        if (event.sequence <= mSequence || mSequence == 0) {
+            mRuns++;
+        }
+        mSequence = event.sequence;
+        gPlaybackTime = event.received;
+
+        if (speed > 0.0 && event.received > first) {
+            std::chrono::duration<double, std::nano> offset(
+                static_cast<double>(event.received - first) / speed);
+            std::this_thread::sleep_until(
+                start + std::chrono::duration_cast<Clock::duration>(offset));
+        }
+
+        LatencyTicks begin = LatencyNow();
+        Deliver(event);
+        context.restart();
+        context.poll();
+        if (event.type < mLatency.size()) {
+            mLatency[event.type].Record(LatencyNow() - begin);
+        }
+    }
+}
+
+void EventPlayback::Deliver(const EventRecord &event) {
+    auto instrument = static_cast<Instrument>(event.instrument);
+    auto value = [&event](std::size_t i) {
+        return static_cast<unsigned long>(event.values[i]);
+    };
+    switch (static_cast<EventType>(event.type)) {
+    case EventType::ORDER_BOOK:
+        mTrader.OrderBookMessageHandler(instrument, event.id, event.levels[0],
+                                        event.levels[1], event.levels[2],
+                                        event.levels[3]);
+        break;
+    case EventType::TRADE_TICKS:
+        mTrader.TradeTicksMessageHandler(instrument, event.id,
+                                         event.levels[0], event.levels[1],
+                                         event.levels[2], event.levels[3]);
+        break;
+    case EventType::ORDER_STATUS:
+        mUnmatched += !Known(event.id);
+        mTrader.OrderStatusMessageHandler(event.id, value(0), value(1),
+                                          event.values[2]);
+        break;
+    case EventType::ORDER_FILLED:
+        mUnmatched += !Known(event.id);
+        mTrader.OrderFilledMessageHandler(event.id, value(0), value(1));
+        break;
+    case EventType::HEDGE_FILLED:
+        mUnmatched += !Known(event.id);
+        mTrader.HedgeFilledMessageHandler(event.id, value(0), value(1));
+        break;
+    case EventType::ERROR:
+        mTrader.ErrorMessageHandler(event.id, event.message);
+        break;
+    case EventType::DISCONNECT:
+        mTrader.DisconnectHandler();
+        break;
+    case EventType::COUNT:
+        break;
+    }
+}
+
+LatencySummary EventPlayback::Summary(EventType type) const {
+    const LatencyHistogram &histogram =
+        mLatency[static_cast<std::size_t>(type)];
+    double scale = mClock.NanosecondsPerTick();
+    return {histogram.Count(), histogram.Percentile(0.50) * scale,
+            histogram.Percentile(0.99) * scale,
+            histogram.Percentile(0.999) * scale, histogram.Max() * scale};
+}
+
+void EventPlayback::Sent(unsigned long clientOrderId) {
+    if (clientOrderId >= mSent.size()) {
+        mSent.resize(clientOrderId * 2 + 1);
+    }
+    mSent[clientOrderId] = true;
+}
+
+bool EventPlayback::Known(unsigned long clientOrderId) const {
+    return clientOrderId < mSent.size() && mSent[clientOrderId];
+}
+
+void EventPlayback::Log(const char *kind, unsigned long clientOrderId,
+                        const char *side, unsigned long price,
+                        unsigned long volume) {
+    if (mRequestLog != nullptr) {
+        *mRequestLog << mSequence << ' ' << kind << ' ' << clientOrderId << ' '
+                     << side << ' ' << price << ' ' << volume << '\n';
+    }
+}
+
+void EventPlayback::AmendOrder(unsigned long clientOrderId,
+                               unsigned long volume) {
+    mRequests[AMEND]++;
+    Log("amend", clientOrderId, "-", 0, volume);
+}
+
+void EventPlayback::CancelOrder(unsigned long clientOrderId) {
+    mRequests[CANCEL]++;
+    Log("cancel", clientOrderId, "-", 0, 0);
+}
+
+void EventPlayback::HedgeOrder(unsigned long clientOrderId, Side side,
+                               unsigned long price, unsigned long volume) {
+    mRequests[HEDGE]++;
+    Sent(clientOrderId);
+    Log("hedge", clientOrderId, SideName(side), price, volume);
+}
+
+void EventPlayback::InsertOrder(unsigned long clientOrderId, Side side,
+                                unsigned long price, unsigned long volume,
+                                Lifespan lifespan) {
+    mRequests[INSERT]++;
+    Sent(clientOrderId);
+    Log("insert", clientOrderId, SideName(side), price, volume);
+}
@@ -0,0 +1,103 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_EVENTPLAYBACK_H
+#define CPPREADY_TRADER_GO_EVENTPLAYBACK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/types.h>
+
+#include <eventrecorder.h>
+#include <latency.h>
+
+// Feeds an event file recorded by a bot back to an autotrader, event by
+// event in the order they were received, so that a run can be reproduced
+// exactly and timed against the same sequence of events.
+//
+// Every callback gets the arguments it was recorded with, whatever the
+// trader sends in between: replies come from the recording, not from a
+// simulated exchange, and the trader's own requests are only counted (and
+// logged if asked). ExchangeClockNow() returns each event's receive time,
+// so a deterministic trader makes the same decisions at any speed.
+class EventPlayback : public ReadyTraderGo::ExecutionSink {
+public:
+    enum RequestKind { AMEND, CANCEL, HEDGE, INSERT, REQUEST_KIND_COUNT };
+
+    // Requests are written to requestLog, one line each (the sequence of
+    // the event being handled, then the request), if it is not null.
+    explicit EventPlayback(ReadyTraderGo::BaseAutoTrader &trader,
+                           std::ostream *requestLog = nullptr);
+
+    // Deliver every event, running whatever the trader posts to context
+    // after each. A speed of zero replays as fast as possible; otherwise
+    // events are paced to their receive times divided by speed.
+    void Run(const EventReader &events, boost::asio::io_context &context,
+             double speed);
+
+    // Handler time, from the call until what it posted has run, in
+    // nanoseconds, per event type.
+    LatencySummary Summary(EventType type) const;
+
+    unsigned long Requests(RequestKind kind) const { return mRequests[kind]; }
+
+    // Order statuses and fills for ids the trader never sent, which means
+    // the replay has diverged from the recording.
+    unsigned long Unmatched() const { return mUnmatched; }
+
+    // How many times the recording starts again from sequence one.
+    unsigned long Runs() const { return mRuns; }
+
+    void AmendOrder(unsigned long clientOrderId,
+                    unsigned long volume) override;
+    void CancelOrder(unsigned long clientOrderId) override;
+    void HedgeOrder(unsigned long clientOrderId, ReadyTraderGo::Side side,
+                    unsigned long price, unsigned long volume) override;
+    void InsertOrder(unsigned long clientOrderId, ReadyTraderGo::Side side,
+                     unsigned long price, unsigned long volume,
+                     ReadyTraderGo::Lifespan lifespan) override;
+
+private:
+    void Deliver(const EventRecord &event);
+    void Sent(unsigned long clientOrderId);
+    bool Known(unsigned long clientOrderId) const;
+    void Log(const char *kind, unsigned long clientOrderId, const char *side,
+             unsigned long price, unsigned long volume);
+
+    ReadyTraderGo::BaseAutoTrader &mTrader;
+    std::ostream *mRequestLog;
+
+    std::uint64_t mSequence = 0;
+    std::array<unsigned long, REQUEST_KIND_COUNT> mRequests{};
+    std::vector<bool> mSent;
+    unsigned long mUnmatched = 0;
+    unsigned long mRuns = 0;
+
+    LatencyMonitor mClock;
+    std::array<LatencyHistogram, static_cast<std::size_t>(EventType::COUNT)>
+        mLatency;
+};
+
+#endif // CPPREADY_TRADER_GO_EVENTPLAYBACK_H
@@ -0,0 +1,123 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Replays an event file recorded by the autotrader or the agg bot into the
+// AutoTrader, and prints how long each kind of event took to handle.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+
+#include "autotrader.h"
+#include "eventplayback.h"
+
+static void Usage(const char *name) {
+    std::cerr
+        << "usage: " << name << " EVENT_FILE [options]\n"
+        << "  --speed FACTOR      pace events at FACTOR times their recorded "
+           "speed (default 0, as fast as possible)\n"
+        << "  --requests FILE     write every request the trader sends"
+        << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc % 2 != 0) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    double speed = 0.0;
+    std::string requestsFile;
+    for (int i = 2; i < argc; i += 2) {
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--speed") {
+            speed = std::stod(value);
+        } else if (option == "--requests") {
+            requestsFile = value;
+        } else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Formatting log records would dominate the timings.
+    boost::log::core::get()->set_logging_enabled(false);
+
+    try {
+        EventReader events(argv[1]);
+
+        std::unique_ptr<std::ofstream> requests;
+        if (!requestsFile.empty()) {
+            requests = std::make_unique<std::ofstream>(requestsFile);
+            if (!*requests) {
+                throw std::runtime_error("could not write " + requestsFile);
+            }
+        }
+
+        boost::asio::io_context context;
+        AutoTrader trader(context, StrategyParams(), "");
+        EventPlayback playback(trader, requests.get());
+
+        auto start = std::chrono::steady_clock::now();
+        playback.Run(events, context, speed);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        std::printf("%-14s %10s %10s %10s %10s %10s\n", "event", "count",
+                    "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+        for (std::size_t i = 0; i < static_cast<std::size_t>(EventType::COUNT);
+             i++) {
+            auto type = static_cast<EventType>(i);
+            LatencySummary summary = playback.Summary(type);
+            if (summary.count == 0) {
+                continue;
+            }
+            std::printf("%-14s %10lu %10.0f %10.0f %10.0f %10.0f\n",
+                        EventTypeName(type),
+                        static_cast<unsigned long>(summary.count),
+                        summary.p50, summary.p99, summary.p999, summary.max);
+        }
+        std::cout << "requests:                "
+                  << playback.Requests(EventPlayback::INSERT) << " inserts, "
+                  << playback.Requests(EventPlayback::AMEND) << " amends, "
+                  << playback.Requests(EventPlayback::CANCEL) << " cancels, "
+                  << playback.Requests(EventPlayback::HEDGE) << " hedges\n"
+                  << "unmatched replies:       " << playback.Unmatched()
+                  << '\n'
+                  << "runs:                    " << playback.Runs() << '\n'
+                  << "replayed " << events.Size() << " events in "
+                  << elapsed.count() << "s" << std::endl;
+        if (playback.Unmatched() != 0) {
+            std::cout << "DIVERGED: replies for orders this build never sent"
+                      << std::endl;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
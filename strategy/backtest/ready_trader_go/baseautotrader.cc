@@ -0,0 +1,45 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include <ready_trader_go/baseautotrader.h>
+
+namespace ReadyTraderGo {
+
+void BaseAutoTrader::SendAmendOrder(unsigned long clientOrderId,
+                                    unsigned long volume) {
+    mSink->AmendOrder(clientOrderId, volume);
+}
+
+void BaseAutoTrader::SendCancelOrder(unsigned long clientOrderId) {
+    mSink->CancelOrder(clientOrderId);
+}
+
+void BaseAutoTrader::SendHedgeOrder(unsigned long clientOrderId, Side side,
+                                    unsigned long price,
+                                    unsigned long volume) {
+    mSink->HedgeOrder(clientOrderId, side, price, volume);
+}
+
+void BaseAutoTrader::SendInsertOrder(unsigned long clientOrderId, Side side,
+                                     unsigned long price,
+                                     unsigned long volume,
+                                     Lifespan lifespan) {
+    mSink->InsertOrder(clientOrderId, side, price, volume, lifespan);
+}
+
+} // namespace ReadyTraderGo
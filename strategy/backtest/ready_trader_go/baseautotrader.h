@@ -0,0 +1,103 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Stand-in for libs/ready_trader_go/baseautotrader.h used by the backtest
+// build. It has the same handler and Send* interface as the real base class
+// but no connections: every request is handed straight to an ExecutionSink.
+#ifndef CPPREADY_TRADER_GO_BACKTEST_BASEAUTOTRADER_H
+#define CPPREADY_TRADER_GO_BACKTEST_BASEAUTOTRADER_H
+
+#include <array>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+
+#include <ready_trader_go/types.h>
+
+namespace ReadyTraderGo {
+
+// Receives every request an autotrader sends to the exchange.
+class ExecutionSink {
+public:
+    virtual ~ExecutionSink() = default;
+
+    virtual void AmendOrder(unsigned long clientOrderId,
+                            unsigned long volume) = 0;
+    virtual void CancelOrder(unsigned long clientOrderId) = 0;
+    virtual void HedgeOrder(unsigned long clientOrderId, Side side,
+                            unsigned long price, unsigned long volume) = 0;
+    virtual void InsertOrder(unsigned long clientOrderId, Side side,
+                             unsigned long price, unsigned long volume,
+                             Lifespan lifespan) = 0;
+};
+
+class BaseAutoTrader {
+public:
+    explicit BaseAutoTrader(boost::asio::io_context &context)
+        : mContext(context) {}
+    virtual ~BaseAutoTrader() = default;
+
+    virtual void DisconnectHandler() {}
+    virtual void ErrorMessageHandler(unsigned long clientOrderId,
+                                     const std::string &errorMessage) {}
+    virtual void HedgeFilledMessageHandler(unsigned long clientOrderId,
+                                           unsigned long price,
+                                           unsigned long volume) {}
+    virtual void OrderBookMessageHandler(
+        Instrument instrument, unsigned long sequenceNumber,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &askPrices,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes) {}
+    virtual void OrderFilledMessageHandler(unsigned long clientOrderId,
+                                           unsigned long price,
+                                           unsigned long volume) {}
+    virtual void OrderStatusMessageHandler(unsigned long clientOrderId,
+                                           unsigned long fillVolume,
+                                           unsigned long remainingVolume,
+                                           signed long fees) {}
+    virtual void TradeTicksMessageHandler(
+        Instrument instrument, unsigned long sequenceNumber,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &askPrices,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &askVolumes,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &bidPrices,
+        const std::array<unsigned long, TOP_LEVEL_COUNT> &bidVolumes) {}
+
+    // Out of line, as in the real base class, so that the handlers calling
+    // them compile to the same code in both builds and profiles taken from
+    // the backtest apply to the autotrader (see autotrader_pgo).
+    void SendAmendOrder(unsigned long clientOrderId, unsigned long volume);
+    void SendCancelOrder(unsigned long clientOrderId);
+    void SendHedgeOrder(unsigned long clientOrderId, Side side,
+                        unsigned long price, unsigned long volume);
+    void SendInsertOrder(unsigned long clientOrderId, Side side,
+                         unsigned long price, unsigned long volume,
+                         Lifespan lifespan);
+
+    void SetExecutionSink(ExecutionSink *sink) { mSink = sink; }
+
+protected:
+    boost::asio::io_context &mContext;
+
+private:
+    ExecutionSink *mSink = nullptr;
+};
+
+} // namespace ReadyTraderGo
+
+#endif // CPPREADY_TRADER_GO_BACKTEST_BASEAUTOTRADER_H
@@ -0,0 +1,102 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+#include "replay.h"
+
+using namespace ReadyTraderGo;
+
+ReplaySession::ReplaySession(const std::string &prefix) {
+    // Streams are indexed the same way the recorder names its captures.
+    static const char *SUFFIXES[STREAM_COUNT] = {
+        "_future_book.col", "_future_ticks.col", "_etf_book.col",
+        "_etf_ticks.col"};
+
+    std::size_t total = 0;
+    for (std::size_t s = 0; s < STREAM_COUNT; s++) {
+        std::string filename = prefix + SUFFIXES[s];
+        bool isBook = s % 2 == 0;
+        if (!isBook && !std::filesystem::exists(filename)) {
+            continue;
+        }
+        mStreams[s] = std::make_unique<CaptureReader>(filename);
+        if (mStreams[s]->Size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error(filename + " has too many rows to replay");
+        }
+        total += mStreams[s]->Size();
+    }
+
+    // Every capture is already in arrival order, so a k-way merge on the
+    // receive timestamps restores the order across all of them.
+    mSteps.reserve(total);
+    std::array<std::size_t, STREAM_COUNT> next{};
+    for (std::size_t n = 0; n < total; n++) {
+        std::size_t best = STREAM_COUNT;
+        std::uint64_t bestTime = std::numeric_limits<std::uint64_t>::max();
+        for (std::size_t s = 0; s < STREAM_COUNT; s++) {
+            if (mStreams[s] && next[s] < mStreams[s]->Size() &&
+                mStreams[s]->Timestamps()[next[s]] < bestTime) {
+                best = s;
+                bestTime = mStreams[s]->Timestamps()[next[s]];
+            }
+        }
+        mSteps.push_back({static_cast<std::uint32_t>(next[best]++),
+                          static_cast<std::uint8_t>(best)});
+    }
+}
+
+SimResult ReplaySession::Run(BaseAutoTrader &trader,
+                             const SimExchangeConfig &config,
+                             boost::asio::io_context &context) const {
+    SimExchange exchange(config, trader);
+    trader.SetExecutionSink(&exchange);
+
+    for (const Step &step : mSteps) {
+        const CaptureReader &stream = *mStreams[step.stream];
+        CaptureRow row = stream.Row(step.row);
+        Instrument instrument = stream.GetInstrument();
+
+        exchange.SetTime(row.timestamp);
+        if (stream.GetType() == RecordType::ORDER_BOOK) {
+            exchange.OnOrderBook(instrument, row.askPrices, row.askVolumes,
+                                 row.bidPrices, row.bidVolumes);
+            exchange.Dispatch();
+            trader.OrderBookMessageHandler(instrument, row.sequenceNumber,
+                                           row.askPrices, row.askVolumes,
+                                           row.bidPrices, row.bidVolumes);
+        } else {
+            exchange.OnTradeTicks(instrument, row.askPrices, row.askVolumes,
+                                  row.bidPrices, row.bidVolumes);
+            exchange.Dispatch();
+            trader.TradeTicksMessageHandler(instrument, row.sequenceNumber,
+                                            row.askPrices, row.askVolumes,
+                                            row.bidPrices, row.bidVolumes);
+        }
+        exchange.Dispatch();
+
+        context.restart();
+        if (context.poll() != 0) {
+            exchange.Dispatch();
+        }
+    }
+
+    trader.SetExecutionSink(nullptr);
+    return exchange.Result();
+}
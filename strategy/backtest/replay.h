@@ -0,0 +1,65 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_REPLAY_H
+#define CPPREADY_TRADER_GO_REPLAY_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+
+#include <ready_trader_go/baseautotrader.h>
+
+#include <capture.h>
+
+#include "simexchange.h"
+
+// The market data of one recorded agg session, merged back into the order it
+// arrived in. A session only reads its captures, so any number of backtests
+// may replay the same session at once.
+class ReplaySession {
+public:
+    // Maps <prefix>_{etf,future}_{book,ticks}.col. The book captures must
+    // exist; trade tick captures are used if present. Throws
+    // std::runtime_error if a capture cannot be read.
+    explicit ReplaySession(const std::string &prefix);
+
+    std::size_t Size() const { return mSteps.size(); }
+
+    // Replays the whole session into trader against a fresh SimExchange.
+    // Anything the trader posts to context runs after each event.
+    SimResult Run(ReadyTraderGo::BaseAutoTrader &trader,
+                  const SimExchangeConfig &config,
+                  boost::asio::io_context &context) const;
+
+private:
+    static constexpr std::size_t STREAM_COUNT = 4;
+
+    struct Step {
+        std::uint32_t row;
+        std::uint8_t stream;
+    };
+
+    std::array<std::unique_ptr<CaptureReader>, STREAM_COUNT> mStreams;
+    std::vector<Step> mSteps;
+};
+
+#endif // CPPREADY_TRADER_GO_REPLAY_H
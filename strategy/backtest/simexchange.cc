@@ -0,0 +1,379 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "allocationcheck.h"
+#include "exchangeclock.h"
+#include "simexchange.h"
+
+using namespace ReadyTraderGo;
+
+// Each backtest runs on a single thread, so the clock the autotrader reads
+// follows the exchange that thread is running.
+static thread_local std::uint64_t tSimTime = 0;
+
+std::uint64_t ExchangeClockNow() { return tSimTime; }
+
+bool LoadSimExchangeConfig(const std::string &filename,
+                           SimExchangeConfig &config) {
+    boost::property_tree::ptree tree;
+    try {
+        boost::property_tree::read_json(filename, tree);
+    } catch (const boost::property_tree::json_parser_error &) {
+        return false;
+    }
+
+    SimExchangeConfig loaded = config;
+    loaded.makerFee = tree.get("Fees.Maker", loaded.makerFee);
+    loaded.takerFee = tree.get("Fees.Taker", loaded.takerFee);
+    loaded.positionLimit =
+        tree.get("Limits.PositionLimit", loaded.positionLimit);
+    loaded.activeOrderCountLimit =
+        tree.get("Limits.ActiveOrderCountLimit", loaded.activeOrderCountLimit);
+    loaded.activeVolumeLimit =
+        tree.get("Limits.ActiveVolumeLimit", loaded.activeVolumeLimit);
+    loaded.messageFrequencyLimit =
+        tree.get("Limits.MessageFrequencyLimit", loaded.messageFrequencyLimit);
+    loaded.messageFrequencyInterval = static_cast<std::uint64_t>(
+        tree.get("Limits.MessageFrequencyInterval", 1.0) * 1e9);
+    config = loaded;
+    return true;
+}
+
+static long Fee(unsigned long price, unsigned long volume, double rate) {
+    return std::lround(static_cast<double>(price) * volume * rate);
+}
+
+static long long Mid(const std::array<unsigned long, TOP_LEVEL_COUNT> &asks,
+                     const std::array<unsigned long, TOP_LEVEL_COUNT> &bids) {
+    if (asks[0] == 0 || bids[0] == 0) {
+        return asks[0] + bids[0];
+    }
+    return (asks[0] + bids[0]) / 2;
+}
+
+SimExchange::SimExchange(const SimExchangeConfig &config,
+                         BaseAutoTrader &trader)
+    : mConfig(config), mTrader(trader) {
+    mOrders.reserve(2 * config.activeOrderCountLimit);
+    mEvents.reserve(64);
+}
+
+void SimExchange::SetTime(std::uint64_t time) {
+    mTime = time;
+    tSimTime = time;
+}
+
+void SimExchange::CountMessage() {
+    mResult.messages++;
+    while (!mMessageTimes.empty() &&
+           mMessageTimes.front() + mConfig.messageFrequencyInterval <= mTime) {
+        mMessageTimes.pop_front();
+    }
+    mMessageTimes.push_back(mTime);
+    mResult.maxMessagesPerInterval = std::max<unsigned long>(
+        mResult.maxMessagesPerInterval, mMessageTimes.size());
+    if (mMessageTimes.size() > mConfig.messageFrequencyLimit) {
+        mResult.messageLimitBreached = true;
+    }
+}
+
+void SimExchange::Error(unsigned long id, const char *message) {
+    mResult.errors++;
+    mEvents.push_back({Event::ERROR, id, 0, 0, 0, message});
+}
+
+void SimExchange::Status(const SimOrder &order) {
+    mEvents.push_back({Event::ORDER_STATUS, order.id, order.filled,
+                       order.remaining, order.fees, nullptr});
+}
+
+SimExchange::SimOrder *SimExchange::Find(unsigned long id) {
+    for (auto &order : mOrders) {
+        if (order.id == id) {
+            return &order;
+        }
+    }
+    return nullptr;
+}
+
+void SimExchange::Remove(unsigned long id) {
+    mOrders.erase(std::remove_if(mOrders.begin(), mOrders.end(),
+                                 [id](const SimOrder &order) {
+                                     return order.id == id;
+                                 }),
+                  mOrders.end());
+}
+
+void SimExchange::Fill(SimOrder &order, unsigned long price,
+                       unsigned long volume, bool maker) {
+    long fee = Fee(price, volume, maker ? mConfig.makerFee : mConfig.takerFee);
+    order.remaining -= volume;
+    order.filled += volume;
+    order.fees += fee;
+    mActiveVolume -= volume;
+
+    long long notional = static_cast<long long>(price) * volume;
+    if (order.side == Side::BUY) {
+        mResult.etfPosition += volume;
+        mResult.cash -= notional;
+    } else {
+        mResult.etfPosition -= volume;
+        mResult.cash += notional;
+    }
+    mResult.cash -= fee;
+    mResult.fees += fee;
+    mResult.etfTradedVolume += volume;
+    mResult.fills++;
+    mResult.maxAbsEtfPosition =
+        std::max(mResult.maxAbsEtfPosition, std::abs(mResult.etfPosition));
+    if (std::abs(mResult.etfPosition) > mConfig.positionLimit) {
+        mResult.positionLimitBreached = true;
+    }
+
+    mEvents.push_back(
+        {Event::ORDER_FILLED, order.id, price, volume, 0, nullptr});
+}
+
+void SimExchange::AmendOrder(unsigned long clientOrderId,
+                             unsigned long volume) {
+    HotPathExempt exempt;
+    CountMessage();
+    SimOrder *order = Find(clientOrderId);
+    if (order == nullptr) {
+        return;
+    }
+    if (volume > order->volume) {
+        Error(clientOrderId, "amend must not increase the volume");
+        return;
+    }
+
+    unsigned long remaining =
+        volume > order->filled ? volume - order->filled : 0;
+    mActiveVolume -= order->remaining - remaining;
+    order->volume = order->filled + remaining;
+    order->remaining = remaining;
+    Status(*order);
+    if (remaining == 0) {
+        Remove(clientOrderId);
+    }
+}
+
+void SimExchange::CancelOrder(unsigned long clientOrderId) {
+    HotPathExempt exempt;
+    CountMessage();
+    SimOrder *order = Find(clientOrderId);
+    if (order == nullptr) {
+        return;
+    }
+    mActiveVolume -= order->remaining;
+    order->remaining = 0;
+    Status(*order);
+    Remove(clientOrderId);
+}
+
+void SimExchange::HedgeOrder(unsigned long clientOrderId, Side side,
+                             unsigned long price, unsigned long volume) {
+    HotPathExempt exempt;
+    CountMessage();
+    const Levels &prices =
+        side == Side::BUY ? mFuture.askPrices : mFuture.bidPrices;
+    const Levels &volumes =
+        side == Side::BUY ? mFuture.askVolumes : mFuture.bidVolumes;
+
+    // Hedges are treated as an infinitely deep market order: walk the
+    // recorded levels and fill any remainder at the last price reached.
+    unsigned long remaining = volume;
+    unsigned long lastPrice = 0;
+    long long notional = 0;
+    for (int i = 0; i < TOP_LEVEL_COUNT && remaining > 0 && prices[i] != 0;
+         i++) {
+        if (side == Side::BUY ? prices[i] > price : prices[i] < price) {
+            break;
+        }
+        unsigned long traded = std::min(remaining, volumes[i]);
+        notional += static_cast<long long>(prices[i]) * traded;
+        remaining -= traded;
+        lastPrice = prices[i];
+    }
+    if (lastPrice == 0) {
+        mEvents.push_back(
+            {Event::HEDGE_FILLED, clientOrderId, 0, 0, 0, nullptr});
+        return;
+    }
+    notional += static_cast<long long>(lastPrice) * remaining;
+
+    if (side == Side::BUY) {
+        mResult.futurePosition += volume;
+        mResult.cash -= notional;
+    } else {
+        mResult.futurePosition -= volume;
+        mResult.cash += notional;
+    }
+    mResult.hedges++;
+
+    unsigned long averagePrice = static_cast<unsigned long>(
+        std::llround(static_cast<double>(notional) / volume));
+    mEvents.push_back(
+        {Event::HEDGE_FILLED, clientOrderId, averagePrice, volume, 0, nullptr});
+}
+
+void SimExchange::InsertOrder(unsigned long clientOrderId, Side side,
+                              unsigned long price, unsigned long volume,
+                              Lifespan lifespan) {
+    HotPathExempt exempt;
+    CountMessage();
+    if (volume == 0 || price == 0 || Find(clientOrderId) != nullptr) {
+        Error(clientOrderId, "invalid order");
+        return;
+    }
+    if (mOrders.size() >= mConfig.activeOrderCountLimit) {
+        Error(clientOrderId, "active order count limit breached");
+        return;
+    }
+    if (mActiveVolume + volume > mConfig.activeVolumeLimit) {
+        Error(clientOrderId, "active volume limit breached");
+        return;
+    }
+
+    SimOrder order{clientOrderId, side, price, volume, volume, 0, 0};
+    mActiveVolume += volume;
+
+    // Take whatever the recorded book offers at our price or better. The
+    // levels we take are used up until the next book arrives.
+    Levels &prices = side == Side::BUY ? mEtf.askPrices : mEtf.bidPrices;
+    Levels &volumes = side == Side::BUY ? mEtf.askVolumes : mEtf.bidVolumes;
+    for (int i = 0; i < TOP_LEVEL_COUNT && order.remaining > 0; i++) {
+        if (prices[i] == 0 ||
+            (side == Side::BUY ? prices[i] > price : prices[i] < price)) {
+            break;
+        }
+        unsigned long traded = std::min(order.remaining, volumes[i]);
+        if (traded != 0) {
+            Fill(order, prices[i], traded, false);
+            volumes[i] -= traded;
+        }
+    }
+
+    if (lifespan == Lifespan::FILL_AND_KILL) {
+        mActiveVolume -= order.remaining;
+        order.remaining = 0;
+    }
+    Status(order);
+    if (order.remaining > 0) {
+        mOrders.push_back(order);
+    }
+}
+
+void SimExchange::MatchResting(const Levels &buyPrices,
+                               const Levels &buyVolumes,
+                               const Levels &sellPrices,
+                               const Levels &sellVolumes) {
+    Levels buyLeft = buyVolumes;
+    Levels sellLeft = sellVolumes;
+
+    bool anyDone = false;
+    for (auto &order : mOrders) {
+        bool isSell = order.side == Side::SELL;
+        const Levels &prices = isSell ? buyPrices : sellPrices;
+        Levels &left = isSell ? buyLeft : sellLeft;
+
+        unsigned long filled = 0;
+        for (int i = 0; i < TOP_LEVEL_COUNT && order.remaining > filled;
+             i++) {
+            if (prices[i] == 0 ||
+                (isSell ? prices[i] < order.price : prices[i] > order.price)) {
+                break;
+            }
+            unsigned long traded = std::min(order.remaining - filled, left[i]);
+            left[i] -= traded;
+            filled += traded;
+        }
+        if (filled != 0) {
+            Fill(order, order.price, filled, true);
+            Status(order);
+            anyDone |= order.remaining == 0;
+        }
+    }
+
+    if (anyDone) {
+        mOrders.erase(std::remove_if(mOrders.begin(), mOrders.end(),
+                                     [](const SimOrder &order) {
+                                         return order.remaining == 0;
+                                     }),
+                      mOrders.end());
+    }
+}
+
+void SimExchange::OnOrderBook(Instrument instrument, const Levels &askPrices,
+                              const Levels &askVolumes,
+                              const Levels &bidPrices,
+                              const Levels &bidVolumes) {
+    Book &book = instrument == Instrument::ETF ? mEtf : mFuture;
+    book = {askPrices, askVolumes, bidPrices, bidVolumes};
+    if (instrument == Instrument::ETF) {
+        MatchResting(bidPrices, bidVolumes, askPrices, askVolumes);
+    }
+}
+
+void SimExchange::OnTradeTicks(Instrument instrument, const Levels &askPrices,
+                               const Levels &askVolumes,
+                               const Levels &bidPrices,
+                               const Levels &bidVolumes) {
+    // Trades on the ask side were buyers lifting offers, so they could have
+    // lifted our sells; trades on the bid side could have hit our buys.
+    if (instrument == Instrument::ETF) {
+        MatchResting(askPrices, askVolumes, bidPrices, bidVolumes);
+    }
+}
+
+void SimExchange::Dispatch() {
+    for (std::size_t i = 0; i < mEvents.size(); i++) {
+        Event event = mEvents[i];
+        switch (event.kind) {
+        case Event::ERROR:
+            mTrader.ErrorMessageHandler(event.id, event.message);
+            break;
+        case Event::ORDER_FILLED:
+            mTrader.OrderFilledMessageHandler(event.id, event.a, event.b);
+            break;
+        case Event::ORDER_STATUS:
+            mTrader.OrderStatusMessageHandler(event.id, event.a, event.b,
+                                              event.fees);
+            break;
+        case Event::HEDGE_FILLED:
+            mTrader.HedgeFilledMessageHandler(event.id, event.a, event.b);
+            break;
+        }
+    }
+    mEvents.clear();
+}
+
+SimResult SimExchange::Result() const {
+    SimResult result = mResult;
+    result.profit = result.cash +
+                    result.etfPosition * Mid(mEtf.askPrices, mEtf.bidPrices) +
+                    result.futurePosition *
+                        Mid(mFuture.askPrices, mFuture.bidPrices);
+    return result;
+}
@@ -0,0 +1,180 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_SIMEXCHANGE_H
+#define CPPREADY_TRADER_GO_SIMEXCHANGE_H
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/types.h>
+
+// The parts of exchange.json the simulated exchange cares about. The
+// defaults are the values the competition runs with.
+struct SimExchangeConfig {
+    double makerFee = -0.0001;
+    double takerFee = 0.0002;
+
+    long positionLimit = 100;
+    unsigned long activeOrderCountLimit = 10;
+    unsigned long activeVolumeLimit = 200;
+    unsigned long messageFrequencyLimit = 50;
+    std::uint64_t messageFrequencyInterval = 1000000000; // nanoseconds
+};
+
+// Reads the Fees and Limits sections of an exchange.json. Returns false, and
+// leaves config untouched, if the file cannot be parsed.
+bool LoadSimExchangeConfig(const std::string &filename,
+                           SimExchangeConfig &config);
+
+struct SimResult {
+    long etfPosition = 0;
+    long futurePosition = 0;
+    long maxAbsEtfPosition = 0;
+
+    // All amounts are in cents.
+    long long cash = 0;
+    long long fees = 0;
+    long long profit = 0;
+
+    unsigned long messages = 0;
+    unsigned long maxMessagesPerInterval = 0;
+    unsigned long etfTradedVolume = 0;
+    unsigned long fills = 0;
+    unsigned long hedges = 0;
+    unsigned long errors = 0;
+
+    bool positionLimitBreached = false;
+    bool messageLimitBreached = false;
+};
+
+// A deliberately simple matching model for offline runs.
+//
+// Orders that cross the ETF book when inserted trade immediately as the
+// taker against the recorded levels. Resting orders trade as the maker, at
+// their own price, whenever a later book or trade tick shows the market
+// trading through or at that price; queue position is not modelled, so fills
+// at our own price are optimistic. Hedge orders trade in full against the
+// future book. Replies are queued and only delivered by Dispatch(), so the
+// autotrader never sees a callback from inside one of its own Send* calls.
+class SimExchange : public ReadyTraderGo::ExecutionSink {
+public:
+    SimExchange(const SimExchangeConfig &config,
+                ReadyTraderGo::BaseAutoTrader &trader);
+
+    // Simulated time of the events that follow, in nanoseconds. This is
+    // also what ExchangeClockNow() returns on the calling thread.
+    void SetTime(std::uint64_t time);
+
+    void OnOrderBook(
+        ReadyTraderGo::Instrument instrument,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &askPrices,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &askVolumes,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &bidPrices,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &bidVolumes);
+    void OnTradeTicks(
+        ReadyTraderGo::Instrument instrument,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &askPrices,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &askVolumes,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &bidPrices,
+        const std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>
+            &bidVolumes);
+
+    // Deliver every queued reply, including any the autotrader causes while
+    // handling them.
+    void Dispatch();
+
+    // The result so far, with open positions marked at the mid price.
+    SimResult Result() const;
+
+    void AmendOrder(unsigned long clientOrderId,
+                    unsigned long volume) override;
+    void CancelOrder(unsigned long clientOrderId) override;
+    void HedgeOrder(unsigned long clientOrderId, ReadyTraderGo::Side side,
+                    unsigned long price, unsigned long volume) override;
+    void InsertOrder(unsigned long clientOrderId, ReadyTraderGo::Side side,
+                     unsigned long price, unsigned long volume,
+                     ReadyTraderGo::Lifespan lifespan) override;
+
+private:
+    using Levels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+    struct Book {
+        Levels askPrices{};
+        Levels askVolumes{};
+        Levels bidPrices{};
+        Levels bidVolumes{};
+    };
+
+    struct SimOrder {
+        unsigned long id;
+        ReadyTraderGo::Side side;
+        unsigned long price;
+        unsigned long volume;
+        unsigned long remaining;
+        unsigned long filled;
+        long fees;
+    };
+
+    struct Event {
+        enum Kind { ERROR, ORDER_FILLED, ORDER_STATUS, HEDGE_FILLED } kind;
+        unsigned long id;
+        unsigned long a;
+        unsigned long b;
+        long fees;
+        const char *message;
+    };
+
+    void CountMessage();
+    void Error(unsigned long id, const char *message);
+    void Fill(SimOrder &order, unsigned long price, unsigned long volume,
+              bool maker);
+    void Status(const SimOrder &order);
+    SimOrder *Find(unsigned long id);
+    void Remove(unsigned long id);
+    // Trade resting orders against liquidity from buyers (for our sells)
+    // and sellers (for our buys).
+    void MatchResting(const Levels &buyPrices, const Levels &buyVolumes,
+                      const Levels &sellPrices, const Levels &sellVolumes);
+
+    SimExchangeConfig mConfig;
+    ReadyTraderGo::BaseAutoTrader &mTrader;
+    std::uint64_t mTime = 0;
+
+    Book mEtf;
+    Book mFuture;
+
+    std::vector<SimOrder> mOrders;
+    std::vector<Event> mEvents;
+    std::deque<std::uint64_t> mMessageTimes;
+    unsigned long mActiveVolume = 0;
+
+    SimResult mResult;
+};
+
+#endif // CPPREADY_TRADER_GO_SIMEXCHANGE_H
@@ -0,0 +1,193 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Runs the backtest over a grid of StrategyParams on every core and prints
+// the runs ranked by profit. Every worker has its own AutoTrader and
+// io_context; they all replay the same read-only mapped session.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+
+#include "autotrader.h"
+#include "replay.h"
+#include "simexchange.h"
+#include "workstealingpool.h"
+
+struct Run {
+    StrategyParams params;
+    SimResult result;
+};
+
+// Parses "value" or "first:last:step" (inclusive) into a list of values.
+static std::vector<double> ParseRange(const std::string &text) {
+    double first, last, step;
+    std::vector<double> values;
+    if (std::sscanf(text.c_str(), "%lf:%lf:%lf", &first, &last, &step) == 3) {
+        if (step <= 0 || last < first) {
+            throw std::invalid_argument("bad range " + text);
+        }
+        // Allow for rounding so that e.g. 0:1:0.1 includes 1.
+        for (double v = first; v <= last + step * 1e-9; v += step) {
+            values.push_back(v);
+        }
+    } else if (std::sscanf(text.c_str(), "%lf", &first) == 1) {
+        values.push_back(first);
+    } else {
+        throw std::invalid_argument("bad range " + text);
+    }
+    return values;
+}
+
+// Runs that breached a limit would have been disqualified, so they rank
+// below every run that did not.
+static bool Better(const Run &a, const Run &b) {
+    bool aBreached =
+        a.result.positionLimitBreached || a.result.messageLimitBreached;
+    bool bBreached =
+        b.result.positionLimitBreached || b.result.messageLimitBreached;
+    if (aBreached != bBreached) {
+        return !aBreached;
+    }
+    return a.result.profit > b.result.profit;
+}
+
+static void PrintTable(const std::vector<Run> &runs, std::size_t top) {
+    std::printf("%5s %7s %6s %9s %14s %9s %8s %9s %8s %s\n", "rank", "margin",
+                "depth", "curvature", "profit", "max|pos|", "end pos",
+                "messages", "max msg", "breach");
+    for (std::size_t i = 0; i < runs.size() && i < top; i++) {
+        const StrategyParams &p = runs[i].params;
+        const SimResult &r = runs[i].result;
+        std::printf("%5zu %7ld %6u %9.3f %14lld %9ld %8ld %9lu %8lu %s%s\n",
+                    i + 1, p.marginBasis, p.maxOrderDepth, p.volumeCurvature,
+                    r.profit, r.maxAbsEtfPosition, r.etfPosition, r.messages,
+                    r.maxMessagesPerInterval,
+                    r.positionLimitBreached ? "position " : "",
+                    r.messageLimitBreached ? "messages" : "");
+    }
+}
+
+static void Usage(const char *name) {
+    std::cerr
+        << "usage: " << name << " CAPTURE_PREFIX [options]\n"
+        << "  --margin RANGE     margin in basis points (default 1:15:1)\n"
+        << "  --depth RANGE      max order depth (default 1:10:1)\n"
+        << "  --curvature RANGE  order size curvature (default 0:1:0.25)\n"
+        << "  --exchange FILE    exchange.json to take fees and limits from\n"
+        << "  --threads N        worker threads (default: all cores)\n"
+        << "  --top N            rows to print (default 20)\n"
+        << "RANGE is a single value or first:last:step." << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string margins = "1:15:1";
+    std::string depths = "1:10:1";
+    std::string curvatures = "0:1:0.25";
+    std::size_t threads = std::thread::hardware_concurrency();
+    std::size_t top = 20;
+    SimExchangeConfig config;
+
+    try {
+        for (int i = 2; i < argc; i += 2) {
+            if (i + 1 >= argc) {
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            std::string option = argv[i];
+            std::string value = argv[i + 1];
+            if (option == "--margin") {
+                margins = value;
+            } else if (option == "--depth") {
+                depths = value;
+            } else if (option == "--curvature") {
+                curvatures = value;
+            } else if (option == "--threads") {
+                threads = std::stoul(value);
+            } else if (option == "--top") {
+                top = std::stoul(value);
+            } else if (option == "--exchange") {
+                if (!LoadSimExchangeConfig(value, config)) {
+                    std::cerr << "could not read " << value << std::endl;
+                    return EXIT_FAILURE;
+                }
+            } else {
+                Usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+
+        std::vector<Run> runs;
+        for (double margin : ParseRange(margins)) {
+            for (double depth : ParseRange(depths)) {
+                for (double curvature : ParseRange(curvatures)) {
+                    StrategyParams params;
+                    params.marginBasis = static_cast<long>(margin);
+                    params.maxOrderDepth = static_cast<unsigned int>(depth);
+                    params.volumeCurvature = curvature;
+                    runs.push_back({params, SimResult()});
+                }
+            }
+        }
+
+        boost::log::core::get()->set_logging_enabled(false);
+
+        ReplaySession session(argv[1]);
+
+        // Each task writes only its own element of runs, which is never
+        // resized while the pool runs.
+        WorkStealingPool pool(threads);
+        for (Run &run : runs) {
+            pool.Submit([&session, &config, &run] {
+                boost::asio::io_context context;
+                AutoTrader trader(context, run.params, "");
+                run.result = session.Run(trader, config, context);
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        pool.Run();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        std::sort(runs.begin(), runs.end(), Better);
+        PrintTable(runs, top);
+        std::cout << runs.size() << " runs of " << session.Size()
+                  << " events in " << elapsed.count() << "s on " << threads
+                  << " threads" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
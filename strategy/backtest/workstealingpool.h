@@ -0,0 +1,112 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_WORKSTEALINGPOOL_H
+#define CPPREADY_TRADER_GO_WORKSTEALINGPOOL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs a batch of independent tasks on a fixed set of threads.
+//
+// Tasks are dealt round-robin onto one deque per worker. A worker takes work
+// from the back of its own deque and, once that is empty, steals from the
+// front of the others, so a few slow tasks cannot leave cores idle. Tasks
+// here are whole backtests, so a mutex per deque costs nothing measurable.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(std::size_t threadCount)
+        : mQueues(threadCount == 0 ? 1 : threadCount) {
+        for (auto &queue : mQueues) {
+            queue = std::make_unique<Queue>();
+        }
+    }
+
+    // Queue a task. Must not be called once Run() has started.
+    void Submit(Task task) {
+        mQueues[mNextQueue]->tasks.push_back(std::move(task));
+        mNextQueue = (mNextQueue + 1) % mQueues.size();
+    }
+
+    // Run every submitted task and return once they have all finished.
+    void Run() {
+        std::vector<std::thread> threads;
+        threads.reserve(mQueues.size());
+        for (std::size_t i = 0; i < mQueues.size(); i++) {
+            threads.emplace_back([this, i] { Work(i); });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool PopBack(std::size_t index, Task &task) {
+        Queue &queue = *mQueues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool StealFront(std::size_t index, Task &task) {
+        Queue &queue = *mQueues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            return false;
+        }
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+    }
+
+    // No tasks are added while the workers run, so a worker that finds every
+    // deque empty can simply stop.
+    void Work(std::size_t self) {
+        Task task;
+        for (;;) {
+            bool found = PopBack(self, task);
+            for (std::size_t i = 1; !found && i < mQueues.size(); i++) {
+                found = StealFront((self + i) % mQueues.size(), task);
+            }
+            if (!found) {
+                return;
+            }
+            task();
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::size_t mNextQueue = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_WORKSTEALINGPOOL_H
@@ -0,0 +1,418 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Microbenchmarks of the autotrader's hot path: the handlers driven by
+// synthetic books and fills against a NullExchange, the quote pricing and
+// the order slabs, and the relay of requests from the pinned trading thread
+// to the I/O thread. Prints ns/op and allocations/op, and can save the results
+// as a baseline or compare them with one.
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/log/core.hpp>
+
+#include <ready_trader_go/types.h>
+
+#include "allocationcheck.h"
+#include "autotrader.h"
+#include "benchharness.h"
+#include "iobridge.h"
+#include "nullexchange.h"
+#include "orderslab.h"
+#include "pricing.h"
+
+using namespace ReadyTraderGo;
+
+using Levels = std::array<unsigned long, TOP_LEVEL_COUNT>;
+
+constexpr unsigned long TICK = 100;
+
+// How often the exchange publishes books.
+constexpr std::uint64_t BOOK_INTERVAL = 250000000;
+
+struct Book {
+    Levels askPrices;
+    Levels askVolumes;
+    Levels bidPrices;
+    Levels bidVolumes;
+};
+
+// A book with its best bid at bestBid, one tick wide and a tick between
+// levels.
+static Book MakeBook(unsigned long bestBid) {
+    Book book;
+    for (std::size_t i = 0; i < TOP_LEVEL_COUNT; i++) {
+        book.bidPrices[i] = bestBid - i * TICK;
+        book.askPrices[i] = bestBid + (i + 1) * TICK;
+        book.bidVolumes[i] = 100 + 10 * i;
+        book.askVolumes[i] = 100 + 10 * i;
+    }
+    return book;
+}
+
+// An AutoTrader with its own io_context, trading against a NullExchange.
+class TraderFixture {
+public:
+    TraderFixture()
+        : mTrader(mContext, StrategyParams(), ""), mExchange(mTrader) {
+        mTrader.SetExecutionSink(&mExchange);
+    }
+    ~TraderFixture() { mTrader.SetExecutionSink(nullptr); }
+
+    TraderFixture(const TraderFixture &) = delete;
+    TraderFixture &operator=(const TraderFixture &) = delete;
+
+    NullExchange &Exchange() { return mExchange; }
+
+    // Deliver the next book of an instrument BOOK_INTERVAL after the last
+    // one, and everything it leads to.
+    void OnBook(Instrument instrument, const Book &book) {
+        mExchange.SetTime(mExchange.Time() + BOOK_INTERVAL);
+        mTrader.OrderBookMessageHandler(
+            instrument, ++mSequences[static_cast<int>(instrument)],
+            book.askPrices, book.askVolumes, book.bidPrices, book.bidVolumes);
+        Settle();
+    }
+
+    // Run whatever the trader posted and deliver the replies, until both
+    // are done.
+    void Settle() {
+        do {
+            mExchange.Dispatch();
+            mContext.restart();
+        } while (mContext.poll() != 0);
+    }
+
+private:
+    boost::asio::io_context mContext;
+    AutoTrader mTrader;
+    NullExchange mExchange;
+    std::array<unsigned long, 2> mSequences{};
+};
+
+static const Book STEADY_BOOK = MakeBook(10000 * TICK);
+
+// The same futures book every time: conflated, repriced and found to need
+// no orders.
+static BenchResult BookSteady(double minSeconds) {
+    TraderFixture fixture;
+    fixture.OnBook(Instrument::ETF, STEADY_BOOK);
+    fixture.OnBook(Instrument::FUTURE, STEADY_BOOK);
+    return RunBench(
+        "book.steady",
+        [&] { fixture.OnBook(Instrument::FUTURE, STEADY_BOOK); }, minSeconds);
+}
+
+// A futures book that moves a tick every time, sweeping up and down eight
+// ticks, so every reprice amends, cancels or inserts.
+static BenchResult BookMoving(double minSeconds) {
+    constexpr unsigned long SWEEP = 8;
+    std::array<Book, 2 * SWEEP> books;
+    for (unsigned long i = 0; i < books.size(); i++) {
+        unsigned long offset = i < SWEEP ? i : 2 * SWEEP - i;
+        books[i] = MakeBook((10000 + offset) * TICK);
+    }
+
+    TraderFixture fixture;
+    fixture.OnBook(Instrument::ETF, STEADY_BOOK);
+    std::size_t next = 0;
+    return RunBench(
+        "book.moving",
+        [&] {
+            fixture.OnBook(Instrument::FUTURE, books[next]);
+            next = (next + 1) % books.size();
+        },
+        minSeconds);
+}
+
+// One lot filled at a time, alternating buys and sells so the position
+// stays within the limit: the fill, the status and the hedge it causes. A
+// side whose orders have all been filled is requoted from a fresh book.
+static BenchResult StatusPartialFills(double minSeconds) {
+    TraderFixture fixture;
+    fixture.OnBook(Instrument::ETF, STEADY_BOOK);
+    fixture.OnBook(Instrument::FUTURE, STEADY_BOOK);
+    Side side = Side::BUY;
+    return RunBench(
+        "status.partial-fills",
+        [&] {
+            if (!fixture.Exchange().Fill(side, 1)) {
+                fixture.OnBook(Instrument::FUTURE, STEADY_BOOK);
+                fixture.Exchange().Fill(side, 1);
+            }
+            fixture.Settle();
+            side = side == Side::BUY ? Side::SELL : Side::BUY;
+        },
+        minSeconds);
+}
+
+// A storm of eight one-lot fills on one side delivered in a single burst,
+// then eight on the other: the statuses are applied and hedged once per
+// burst.
+static BenchResult StatusFillBurst(double minSeconds) {
+    constexpr int BURST = 8;
+    TraderFixture fixture;
+    fixture.OnBook(Instrument::ETF, STEADY_BOOK);
+    fixture.OnBook(Instrument::FUTURE, STEADY_BOOK);
+    Side side = Side::BUY;
+    return RunBench(
+        "status.fill-burst",
+        [&] {
+            for (int i = 0; i < BURST; i++) {
+                if (!fixture.Exchange().Fill(side, 1)) {
+                    fixture.OnBook(Instrument::FUTURE, STEADY_BOOK);
+                    fixture.Exchange().Fill(side, 1);
+                }
+            }
+            fixture.Settle();
+            side = side == Side::BUY ? Side::SELL : Side::BUY;
+        },
+        minSeconds);
+}
+
+// Counts the requests an IoBridge sends, on its I/O thread.
+class CountingSink : public ExecutionSink {
+public:
+    unsigned long Requests() const {
+        return mRequests.load(std::memory_order_acquire);
+    }
+
+    void AmendOrder(unsigned long, unsigned long) override { Count(); }
+    void CancelOrder(unsigned long) override { Count(); }
+    void HedgeOrder(unsigned long, Side, unsigned long,
+                    unsigned long) override {
+        Count();
+    }
+    void InsertOrder(unsigned long, Side, unsigned long, unsigned long,
+                     Lifespan) override {
+        Count();
+    }
+
+private:
+    void Count() { mRequests.fetch_add(1, std::memory_order_release); }
+
+    std::atomic<unsigned long> mRequests{0};
+};
+
+// One cancel queued on this thread, in place of the pinned trading thread,
+// for an IoBridge whose io_context runs on a thread of its own, waiting
+// until that thread has sent it. Every request wakes the I/O thread with a
+// fresh drain, so this times the whole hand-over and counts what queuing
+// it allocates.
+static BenchResult BridgeRequest(double minSeconds) {
+    boost::asio::io_context context;
+    auto work = boost::asio::make_work_guard(context);
+    IoBridge bridge(context);
+    CountingSink sink;
+    bridge.SetExecutionSink(&sink);
+    std::thread io([&context] { context.run(); });
+
+    unsigned long sent = 0;
+    BenchResult result = RunBench(
+        "bridge.request",
+        [&] {
+            {
+                HotPathScope hotPath;
+                bridge.Request({ExecutionRequest::CANCEL, Side::BUY,
+                                Lifespan::GOOD_FOR_DAY, ++sent, 0, 0});
+            }
+            while (sink.Requests() != sent) {
+            }
+        },
+        minSeconds);
+
+    work.reset();
+    io.join();
+    bridge.SetExecutionSink(nullptr);
+    return result;
+}
+
+// Both sides' quotes for a full book.
+static BenchResult PricingQuotePrices(double minSeconds) {
+    Levels references = STEADY_BOOK.bidPrices;
+    Levels asks;
+    Levels bids;
+    unsigned long step = 0;
+    return RunBench(
+        "pricing.quote-prices",
+        [&] {
+            references[step++ % TOP_LEVEL_COUNT] += TICK;
+            KeepAlive(references);
+            QuotePrices<Side::SELL, TICK>(references, 7, asks);
+            QuotePrices<Side::BUY, TICK>(references, 7, bids);
+            KeepAlive(asks);
+            KeepAlive(bids);
+        },
+        minSeconds);
+}
+
+// Insert and erase churn on a nearly full slab: the oldest order goes and a
+// new one arrives at a pseudo-random price among the resting ones.
+template <typename Slab>
+static BenchResult SlabChurn(const std::string &name, double minSeconds) {
+    constexpr std::size_t RESTING = Slab::CAPACITY - 1;
+    Slab slab;
+    unsigned long nextId = 1;
+    std::uint32_t random = 1;
+    auto price = [&random] {
+        random = random * 1664525 + 1013904223;
+        return (10000 + (random >> 28)) * TICK;
+    };
+    for (std::size_t i = 0; i < RESTING; i++) {
+        slab.Insert(nextId++, Order{price(), 10, 0});
+    }
+    return RunBench(
+        name,
+        [&] {
+            slab.Erase(nextId - RESTING);
+            slab.Insert(nextId++, Order{price(), 10, 0});
+            KeepAlive(slab.Best()->order.price);
+        },
+        minSeconds);
+}
+
+static void Usage(const char *name) {
+    std::cerr
+        << "usage: " << name << " [options]\n"
+        << "  --min-time SECONDS  shortest timed batch (default 0.5)\n"
+        << "  --filter TEXT       only run benchmarks whose name contains it\n"
+        << "  --save FILE         write the results as a baseline\n"
+        << "  --compare FILE      compare the results with a baseline\n"
+        << "  --tolerance PERCENT slowdown counted as a regression "
+           "(default 10)"
+        << std::endl;
+}
+
+// Prints a comparison with the baseline and returns how many benchmarks
+// regressed: slowed down by more than the tolerance or allocated more.
+static int Compare(const std::vector<BenchResult> &results,
+                   const std::vector<BenchResult> &baseline,
+                   double tolerance) {
+    int regressions = 0;
+    std::printf("\n%-24s %12s %12s %8s %s\n", "benchmark", "baseline ns",
+                "ns/op", "change", "");
+    for (const BenchResult &result : results) {
+        const BenchResult *base = nullptr;
+        for (const BenchResult &b : baseline) {
+            if (b.name == result.name) {
+                base = &b;
+            }
+        }
+        if (base == nullptr) {
+            std::printf("%-24s %12s %12.1f %8s new\n", result.name.c_str(),
+                        "-", result.nsPerOp, "");
+            continue;
+        }
+        double change = (result.nsPerOp / base->nsPerOp - 1) * 100;
+        bool slower = change > tolerance;
+        bool allocates = result.allocationsPerOp > base->allocationsPerOp;
+        regressions += slower || allocates;
+        std::printf("%-24s %12.1f %12.1f %+7.1f%% %s%s\n",
+                    result.name.c_str(), base->nsPerOp, result.nsPerOp, change,
+                    slower ? "SLOWER " : "", allocates ? "ALLOCATES" : "");
+    }
+    return regressions;
+}
+
+int main(int argc, char *argv[]) {
+    double minSeconds = 0.5;
+    double tolerance = 10;
+    std::string filter;
+    std::string saveFile;
+    std::string compareFile;
+
+    for (int i = 1; i < argc; i += 2) {
+        if (i + 1 >= argc) {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string option = argv[i];
+        std::string value = argv[i + 1];
+        if (option == "--min-time") {
+            minSeconds = std::stod(value);
+        } else if (option == "--filter") {
+            filter = value;
+        } else if (option == "--save") {
+            saveFile = value;
+        } else if (option == "--compare") {
+            compareFile = value;
+        } else if (option == "--tolerance") {
+            tolerance = std::stod(value);
+        } else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Formatting log records would dominate the timings.
+    boost::log::core::get()->set_logging_enabled(false);
+
+    const std::vector<std::pair<std::string,
+                                std::function<BenchResult(double)>>>
+        benchmarks = {
+            {"book.steady", BookSteady},
+            {"book.moving", BookMoving},
+            {"status.partial-fills", StatusPartialFills},
+            {"status.fill-burst", StatusFillBurst},
+            {"bridge.request", BridgeRequest},
+            {"pricing.quote-prices", PricingQuotePrices},
+            {"slab.ask-churn",
+             [](double s) { return SlabChurn<AskSlab>("slab.ask-churn", s); }},
+            {"slab.bid-churn",
+             [](double s) { return SlabChurn<BidSlab>("slab.bid-churn", s); }},
+        };
+
+    try {
+        std::vector<BenchResult> results;
+        std::printf("%-24s %12s %12s %10s\n", "benchmark", "iterations",
+                    "ns/op", "allocs/op");
+        for (const auto &[name, run] : benchmarks) {
+            if (name.find(filter) == std::string::npos) {
+                continue;
+            }
+            results.push_back(run(minSeconds));
+            const BenchResult &r = results.back();
+            std::printf("%-24s %12lu %12.1f %10.2f\n", r.name.c_str(),
+                        r.iterations, r.nsPerOp, r.allocationsPerOp);
+        }
+
+        if (!saveFile.empty()) {
+            SaveBaseline(saveFile, results);
+        }
+        if (!compareFile.empty() &&
+            Compare(results, LoadBaseline(compareFile), tolerance) != 0) {
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
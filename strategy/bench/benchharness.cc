@@ -0,0 +1,116 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include "benchharness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "allocationcheck.h"
+
+#ifdef RTG_ALLOCATION_CHECK
+
+unsigned long BenchAllocations() { return HotPathAllocations(); }
+
+#else
+
+// Count every allocation. libstdc++'s array and nothrow forms go through
+// these, so they are counted too.
+static thread_local unsigned long tAllocations = 0;
+
+static void *Allocate(std::size_t size, std::size_t alignment) {
+    tAllocations++;
+    void *p = alignment == 0
+                  ? std::malloc(size != 0 ? size : 1)
+                  : std::aligned_alloc(alignment, (size + alignment - 1) /
+                                                      alignment * alignment);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new(std::size_t size) { return Allocate(size, 0); }
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+unsigned long BenchAllocations() { return tAllocations; }
+
+#endif
+
+// ptree would write every digit of the double.
+static std::string Format(const char *format, double value) {
+    char text[32];
+    std::snprintf(text, sizeof(text), format, value);
+    return text;
+}
+
+void SaveBaseline(const std::string &filename,
+                  const std::vector<BenchResult> &results) {
+    boost::property_tree::ptree tree;
+    for (const BenchResult &result : results) {
+        boost::property_tree::ptree entry;
+        entry.put("nsPerOp", Format("%.1f", result.nsPerOp));
+        entry.put("allocationsPerOp", Format("%.2f", result.allocationsPerOp));
+        // Unlike put, push_back does not read dots in the name as a path.
+        tree.push_back({result.name, entry});
+    }
+    try {
+        boost::property_tree::write_json(filename, tree);
+    } catch (const boost::property_tree::json_parser_error &e) {
+        throw std::runtime_error("could not write " + filename + ": " +
+                                 e.what());
+    }
+}
+
+std::vector<BenchResult> LoadBaseline(const std::string &filename) {
+    boost::property_tree::ptree tree;
+    try {
+        boost::property_tree::read_json(filename, tree);
+    } catch (const boost::property_tree::json_parser_error &e) {
+        throw std::runtime_error("could not read " + filename + ": " +
+                                 e.what());
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto &[name, entry] : tree) {
+        BenchResult result;
+        result.name = name;
+        result.nsPerOp = entry.get<double>("nsPerOp");
+        result.allocationsPerOp = entry.get<double>("allocationsPerOp");
+        results.push_back(result);
+    }
+    return results;
+}
@@ -0,0 +1,82 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_BENCHHARNESS_H
+#define CPPREADY_TRADER_GO_BENCHHARNESS_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// A small in-house harness for timing the autotrader's hot path.
+//
+// Each benchmark is a callable making one operation. RunBench calls it in
+// batches that double in size until a batch takes at least the minimum
+// time, then reports the last batch: nanoseconds and heap allocations per
+// operation.
+
+struct BenchResult {
+    std::string name;
+    unsigned long iterations = 0;
+    double nsPerOp = 0;
+    double allocationsPerOp = 0;
+};
+
+// Heap allocations made on this thread so far. Built with the allocation
+// check, which replaces operator new itself, only allocations made inside a
+// HotPathScope are counted (see allocationcheck.h).
+unsigned long BenchAllocations();
+
+// Keeps the compiler from discarding a value the benchmark computes but
+// never uses.
+template <typename T> inline void KeepAlive(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename Op>
+BenchResult RunBench(const std::string &name, Op &&op, double minSeconds) {
+    using Clock = std::chrono::steady_clock;
+
+    BenchResult result;
+    result.name = name;
+    for (unsigned long batch = 1;; batch *= 2) {
+        unsigned long allocations = BenchAllocations();
+        auto start = Clock::now();
+        for (unsigned long i = 0; i < batch; i++) {
+            op();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        allocations = BenchAllocations() - allocations;
+
+        if (elapsed.count() >= minSeconds || batch >= (1ul << 40)) {
+            result.iterations = batch;
+            result.nsPerOp = elapsed.count() * 1e9 / batch;
+            result.allocationsPerOp = static_cast<double>(allocations) / batch;
+            return result;
+        }
+    }
+}
+
+// A baseline is a JSON object mapping each benchmark's name to its ns/op
+// and allocations/op. Both throw std::runtime_error if the file cannot be
+// written or read.
+void SaveBaseline(const std::string &filename,
+                  const std::vector<BenchResult> &results);
+std::vector<BenchResult> LoadBaseline(const std::string &filename);
+
+#endif // CPPREADY_TRADER_GO_BENCHHARNESS_H
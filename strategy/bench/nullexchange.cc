@@ -0,0 +1,151 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#include "nullexchange.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "exchangeclock.h"
+
+using namespace ReadyTraderGo;
+
+// Benchmarks run on a single thread, like the backtest.
+static std::uint64_t gBenchTime = 0;
+
+std::uint64_t ExchangeClockNow() { return gBenchTime; }
+
+NullExchange::NullExchange(BaseAutoTrader &trader) : mTrader(trader) {}
+
+void NullExchange::SetTime(std::uint64_t time) {
+    mTime = time;
+    gBenchTime = time;
+}
+
+bool NullExchange::Fill(Side side, unsigned long volume) {
+    auto end = mOrders.begin() + mOrderCount;
+    auto order = std::find_if(mOrders.begin(), end,
+                              [side](const RestingOrder &o) {
+                                  return o.side == side;
+                              });
+    if (order == end) {
+        return false;
+    }
+
+    volume = std::min(volume, order->remaining);
+    order->remaining -= volume;
+    order->filled += volume;
+    Queue({Reply::ORDER_FILLED, order->id, order->price, volume});
+    Status(*order);
+    if (order->remaining == 0) {
+        Remove(*order);
+    }
+    return true;
+}
+
+void NullExchange::Dispatch() {
+    // Handlers may queue more replies behind the one being delivered.
+    for (std::size_t i = 0; i < mReplyCount; i++) {
+        Reply reply = mReplies[i];
+        switch (reply.kind) {
+        case Reply::ORDER_FILLED:
+            mTrader.OrderFilledMessageHandler(reply.id, reply.a, reply.b);
+            break;
+        case Reply::ORDER_STATUS:
+            mTrader.OrderStatusMessageHandler(reply.id, reply.a, reply.b, 0);
+            break;
+        case Reply::HEDGE_FILLED:
+            mTrader.HedgeFilledMessageHandler(reply.id, reply.a, reply.b);
+            break;
+        }
+    }
+    mReplyCount = 0;
+}
+
+void NullExchange::AmendOrder(unsigned long clientOrderId,
+                              unsigned long volume) {
+    mMessages++;
+    RestingOrder *order = Find(clientOrderId);
+    if (order == nullptr) {
+        return;
+    }
+    order->remaining = volume > order->filled ? volume - order->filled : 0;
+    Status(*order);
+    if (order->remaining == 0) {
+        Remove(*order);
+    }
+}
+
+void NullExchange::CancelOrder(unsigned long clientOrderId) {
+    mMessages++;
+    RestingOrder *order = Find(clientOrderId);
+    if (order == nullptr) {
+        return;
+    }
+    order->remaining = 0;
+    Status(*order);
+    Remove(*order);
+}
+
+void NullExchange::HedgeOrder(unsigned long clientOrderId, Side side,
+                              unsigned long price, unsigned long volume) {
+    mMessages++;
+    Queue({Reply::HEDGE_FILLED, clientOrderId, price, volume});
+}
+
+void NullExchange::InsertOrder(unsigned long clientOrderId, Side side,
+                               unsigned long price, unsigned long volume,
+                               Lifespan lifespan) {
+    mMessages++;
+    if (mOrderCount == ORDER_CAPACITY) {
+        throw std::length_error("NullExchange has too many resting orders");
+    }
+    RestingOrder &order = mOrders[mOrderCount++];
+    order = {clientOrderId, side, price, volume, 0};
+    Status(order);
+    if (lifespan == Lifespan::FILL_AND_KILL) {
+        order.remaining = 0;
+        Status(order);
+        Remove(order);
+    }
+}
+
+NullExchange::RestingOrder *NullExchange::Find(unsigned long id) {
+    auto end = mOrders.begin() + mOrderCount;
+    auto order =
+        std::find_if(mOrders.begin(), end,
+                     [id](const RestingOrder &o) { return o.id == id; });
+    return order == end ? nullptr : &*order;
+}
+
+void NullExchange::Remove(const RestingOrder &order) {
+    auto position = mOrders.begin() + (&order - mOrders.data());
+    std::copy(position + 1, mOrders.begin() + mOrderCount, position);
+    mOrderCount--;
+}
+
+void NullExchange::Queue(const Reply &reply) {
+    if (mReplyCount == REPLY_CAPACITY) {
+        throw std::length_error("NullExchange has too many queued replies");
+    }
+    mReplies[mReplyCount++] = reply;
+}
+
+void NullExchange::Status(const RestingOrder &order) {
+    Queue({Reply::ORDER_STATUS, order.id, order.filled, order.remaining});
+}
@@ -0,0 +1,104 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+#ifndef CPPREADY_TRADER_GO_NULLEXCHANGE_H
+#define CPPREADY_TRADER_GO_NULLEXCHANGE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/types.h>
+
+// The cheapest exchange that still keeps the autotrader's view of its
+// orders true, for benchmarks.
+//
+// Nothing trades unless the benchmark asks for it with Fill(). Inserts,
+// amends and cancels are confirmed with the order status the real exchange
+// would send, and hedges fill in full at their limit price. Everything is
+// kept in fixed-size storage, so it adds nothing to the allocation counts,
+// and, as with SimExchange, replies are only delivered by Dispatch().
+class NullExchange : public ReadyTraderGo::ExecutionSink {
+public:
+    explicit NullExchange(ReadyTraderGo::BaseAutoTrader &trader);
+
+    // Time of the events that follow, in nanoseconds; also what
+    // ExchangeClockNow() returns.
+    void SetTime(std::uint64_t time);
+    std::uint64_t Time() const { return mTime; }
+
+    // Trade volume lots of the oldest resting order on a side, if there is
+    // one, and queue its fill and status messages.
+    bool Fill(ReadyTraderGo::Side side, unsigned long volume);
+
+    // Deliver every queued reply, including any the autotrader causes while
+    // handling them.
+    void Dispatch();
+
+    // Order messages received so far.
+    unsigned long Messages() const { return mMessages; }
+
+    void AmendOrder(unsigned long clientOrderId,
+                    unsigned long volume) override;
+    void CancelOrder(unsigned long clientOrderId) override;
+    void HedgeOrder(unsigned long clientOrderId, ReadyTraderGo::Side side,
+                    unsigned long price, unsigned long volume) override;
+    void InsertOrder(unsigned long clientOrderId, ReadyTraderGo::Side side,
+                     unsigned long price, unsigned long volume,
+                     ReadyTraderGo::Lifespan lifespan) override;
+
+private:
+    // More than the exchange's active order count limit, so an order that
+    // breaks it is still tracked rather than lost.
+    static constexpr std::size_t ORDER_CAPACITY = 32;
+    static constexpr std::size_t REPLY_CAPACITY = 256;
+
+    struct RestingOrder {
+        unsigned long id;
+        ReadyTraderGo::Side side;
+        unsigned long price;
+        unsigned long remaining;
+        unsigned long filled;
+    };
+
+    struct Reply {
+        enum Kind { ORDER_FILLED, ORDER_STATUS, HEDGE_FILLED } kind;
+        unsigned long id;
+        unsigned long a;
+        unsigned long b;
+    };
+
+    RestingOrder *Find(unsigned long id);
+    void Remove(const RestingOrder &order);
+    void Queue(const Reply &reply);
+    void Status(const RestingOrder &order);
+
+    ReadyTraderGo::BaseAutoTrader &mTrader;
+    std::uint64_t mTime = 0;
+    unsigned long mMessages = 0;
+
+    // Resting orders, oldest first.
+    std::array<RestingOrder, ORDER_CAPACITY> mOrders{};
+    std::size_t mOrderCount = 0;
+
+    std::array<Reply, REPLY_CAPACITY> mReplies{};
+    std::size_t mReplyCount = 0;
+};
+
+#endif // CPPREADY_TRADER_GO_NULLEXCHANGE_H
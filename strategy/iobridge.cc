@@ -0,0 +1,148 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <algorithm>
+#include <thread>
+
+#include "iobridge.h"
+
+using namespace ReadyTraderGo;
+
+void IoBridge::Publish(const ExchangeEvent &event) {
+    // The trading thread busy-polls, so the ring only fills if it stalls.
+    // Keep its requests moving meanwhile so that neither thread waits on
+    // the other.
+    while (!mEvents.TryPush(event)) {
+        DrainRequests();
+        std::this_thread::yield();
+    }
+}
+
+void IoBridge::DrainRequests() {
+    const ExecutionRequest *requests;
+    while (std::size_t count = mRequests.Peek(&requests)) {
+        for (std::size_t i = 0; i < count; i++) {
+            const ExecutionRequest &request = requests[i];
+            switch (request.type) {
+            case ExecutionRequest::AMEND:
+                SendAmendOrder(request.clientOrderId, request.volume);
+                break;
+            case ExecutionRequest::CANCEL:
+                SendCancelOrder(request.clientOrderId);
+                break;
+            case ExecutionRequest::HEDGE:
+                SendHedgeOrder(request.clientOrderId, request.side,
+                               request.price, request.volume);
+                break;
+            case ExecutionRequest::INSERT:
+                SendInsertOrder(request.clientOrderId, request.side,
+                                request.price, request.volume,
+                                request.lifespan);
+                break;
+            }
+        }
+        mRequests.Release(count);
+    }
+}
+
+void IoBridge::DisconnectHandler() {
+    BaseAutoTrader::DisconnectHandler();
+    ExchangeEvent event{};
+    event.type = ExchangeEvent::DISCONNECT;
+    Publish(event);
+}
+
+void IoBridge::ErrorMessageHandler(unsigned long clientOrderId,
+                                   const std::string &errorMessage) {
+    ExchangeEvent event{};
+    event.type = ExchangeEvent::ERROR_MESSAGE;
+    event.id = clientOrderId;
+    std::size_t length =
+        std::min(errorMessage.size(), ExchangeEvent::MAX_ERROR_LENGTH);
+    errorMessage.copy(event.error, length);
+    event.error[length] = '\0';
+    Publish(event);
+}
+
+void IoBridge::HedgeFilledMessageHandler(unsigned long clientOrderId,
+                                         unsigned long price,
+                                         unsigned long volume) {
+    ExchangeEvent event{};
+    event.type = ExchangeEvent::HEDGE_FILLED;
+    event.id = clientOrderId;
+    event.first = price;
+    event.second = volume;
+    Publish(event);
+}
+
+void IoBridge::OrderBookMessageHandler(
+    Instrument instrument, unsigned long sequenceNumber,
+    const ExchangeEvent::Levels &askPrices,
+    const ExchangeEvent::Levels &askVolumes,
+    const ExchangeEvent::Levels &bidPrices,
+    const ExchangeEvent::Levels &bidVolumes) {
+    ExchangeEvent event;
+    event.type = ExchangeEvent::ORDER_BOOK;
+    event.instrument = instrument;
+    event.id = sequenceNumber;
+    event.askPrices = askPrices;
+    event.askVolumes = askVolumes;
+    event.bidPrices = bidPrices;
+    event.bidVolumes = bidVolumes;
+    Publish(event);
+}
+
+void IoBridge::OrderFilledMessageHandler(unsigned long clientOrderId,
+                                         unsigned long price,
+                                         unsigned long volume) {
+    ExchangeEvent event{};
+    event.type = ExchangeEvent::ORDER_FILLED;
+    event.id = clientOrderId;
+    event.first = price;
+    event.second = volume;
+    Publish(event);
+}
+
+void IoBridge::OrderStatusMessageHandler(unsigned long clientOrderId,
+                                         unsigned long fillVolume,
+                                         unsigned long remainingVolume,
+                                         signed long fees) {
+    ExchangeEvent event{};
+    event.type = ExchangeEvent::ORDER_STATUS;
+    event.id = clientOrderId;
+    event.first = fillVolume;
+    event.second = remainingVolume;
+    event.fees = fees;
+    Publish(event);
+}
+
+void IoBridge::TradeTicksMessageHandler(
+    Instrument instrument, unsigned long sequenceNumber,
+    const ExchangeEvent::Levels &askPrices,
+    const ExchangeEvent::Levels &askVolumes,
+    const ExchangeEvent::Levels &bidPrices,
+    const ExchangeEvent::Levels &bidVolumes) {
+    ExchangeEvent event;
+    event.type = ExchangeEvent::TRADE_TICKS;
+    event.instrument = instrument;
+    event.id = sequenceNumber;
+    event.askPrices = askPrices;
+    event.askVolumes = askVolumes;
+    event.bidPrices = bidPrices;
+    event.bidVolumes = bidVolumes;
+    Publish(event);
+}
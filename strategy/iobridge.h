@@ -0,0 +1,157 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_IOBRIDGE_H
+#define CPPREADY_TRADER_GO_IOBRIDGE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <ready_trader_go/baseautotrader.h>
+#include <ready_trader_go/types.h>
+
+#include "sessionarena.h"
+#include "spscring.h"
+
+// One exchange message, copied off the I/O thread.
+struct ExchangeEvent {
+    enum Type : unsigned char {
+        DISCONNECT,
+        ERROR_MESSAGE,
+        HEDGE_FILLED,
+        ORDER_BOOK,
+        ORDER_FILLED,
+        ORDER_STATUS,
+        TRADE_TICKS
+    };
+
+    static constexpr std::size_t MAX_ERROR_LENGTH = 127;
+
+    using Levels = std::array<unsigned long, ReadyTraderGo::TOP_LEVEL_COUNT>;
+
+    Type type;
+    ReadyTraderGo::Instrument instrument;
+    // The sequence number of a book or ticks, otherwise the client order id.
+    unsigned long id;
+    // Price and volume of fills, fill and remaining volume of statuses.
+    unsigned long first;
+    unsigned long second;
+    signed long fees;
+    Levels askPrices;
+    Levels askVolumes;
+    Levels bidPrices;
+    Levels bidVolumes;
+    // Truncated, and NUL terminated.
+    char error[MAX_ERROR_LENGTH + 1];
+};
+
+// One request for the exchange, queued for the I/O thread.
+struct ExecutionRequest {
+    enum Type : unsigned char { AMEND, CANCEL, HEDGE, INSERT };
+
+    Type type;
+    ReadyTraderGo::Side side;
+    ReadyTraderGo::Lifespan lifespan;
+    unsigned long clientOrderId;
+    unsigned long price;
+    unsigned long volume;
+};
+
+// The half of a threaded autotrader that owns the exchange connections.
+//
+// The Application delivers every message to these handlers on the I/O
+// thread, which only copy it into a ring for the trading thread. Requests
+// come back the other way through a second ring; the first one queued
+// since the I/O thread last looked posts a drain to its io_context, which
+// makes the actual Send* calls. Only one drain is ever posted at a time, so
+// it always reuses the same HandlerSlot and the trading thread never
+// allocates to wake the I/O thread.
+class IoBridge : public ReadyTraderGo::BaseAutoTrader {
+public:
+    static constexpr std::size_t EVENT_CAPACITY = 4096;
+    static constexpr std::size_t REQUEST_CAPACITY = 1024;
+
+    using EventRing = SpscRing<ExchangeEvent, EVENT_CAPACITY>;
+
+    explicit IoBridge(boost::asio::io_context &context)
+        : BaseAutoTrader(context) {}
+
+    void DisconnectHandler() override;
+    void ErrorMessageHandler(unsigned long clientOrderId,
+                             const std::string &errorMessage) override;
+    void HedgeFilledMessageHandler(unsigned long clientOrderId,
+                                   unsigned long price,
+                                   unsigned long volume) override;
+    void OrderBookMessageHandler(
+        ReadyTraderGo::Instrument instrument, unsigned long sequenceNumber,
+        const ExchangeEvent::Levels &askPrices,
+        const ExchangeEvent::Levels &askVolumes,
+        const ExchangeEvent::Levels &bidPrices,
+        const ExchangeEvent::Levels &bidVolumes) override;
+    void OrderFilledMessageHandler(unsigned long clientOrderId,
+                                   unsigned long price,
+                                   unsigned long volume) override;
+    void OrderStatusMessageHandler(unsigned long clientOrderId,
+                                   unsigned long fillVolume,
+                                   unsigned long remainingVolume,
+                                   signed long fees) override;
+    void TradeTicksMessageHandler(
+        ReadyTraderGo::Instrument instrument, unsigned long sequenceNumber,
+        const ExchangeEvent::Levels &askPrices,
+        const ExchangeEvent::Levels &askVolumes,
+        const ExchangeEvent::Levels &bidPrices,
+        const ExchangeEvent::Levels &bidVolumes) override;
+
+    // Trading thread side: the messages received so far.
+    EventRing &Events() { return mEvents; }
+
+    // Trading thread side: queue a request for the I/O thread. Spins while
+    // the ring is full, which the I/O thread resolves by draining it.
+    void Request(const ExecutionRequest &request) {
+        while (!mRequests.TryPush(request)) {
+            WakeIo();
+        }
+        WakeIo();
+    }
+
+private:
+    void Publish(const ExchangeEvent &event);
+
+    void WakeIo() {
+        if (!mDrainPosted.exchange(true, std::memory_order_acq_rel)) {
+            boost::asio::post(mContext, InSlot(&mDrainSlot, [this] {
+                mDrainPosted.store(false, std::memory_order_release);
+                DrainRequests();
+            }));
+        }
+    }
+
+    // I/O thread side: send everything queued.
+    void DrainRequests();
+
+    EventRing mEvents;
+    SpscRing<ExecutionRequest, REQUEST_CAPACITY> mRequests;
+    std::atomic<bool> mDrainPosted{false};
+    HandlerSlot mDrainSlot;
+};
+
+#endif // CPPREADY_TRADER_GO_IOBRIDGE_H
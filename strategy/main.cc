@@ -15,35 +15,60 @@
 //     You should have received a copy of the GNU Affero General Public
 //     License along with Ready Trader Go.  If not, see
 //     <https://www.gnu.org/licenses/>.
-#include <cstdlib>
-#include <iostream>
+#include <filesystem>
+
+#include <boost/asio/io_context.hpp>
 
 #include <ready_trader_go/application.h>
 #include <ready_trader_go/autotraderapphandler.h>
-#include <ready_trader_go/error.h>
 
 #include "autotrader.h"
+#include "botmain.h"
+#include "eventrecorder.h"
+#include "iobridge.h"
+#include "tradingthread.h"
 
 int main(int argc, char* argv[])
 {
-    try
-    {
-        ReadyTraderGo::Application app;
-        AutoTrader trader{app.GetContext()};
-        ReadyTraderGo::AutoTraderAppHandler appHandler{app, trader};
-        app.Run(argc, argv);
-    }
-    catch (const ReadyTraderGo::ReadyTraderGoError& e)
-    {
-        std::cerr << e.what() << std::endl;
-        return EXIT_FAILURE;
-    }
-    catch (...)
-    {
-        // Catch block added so the Application object gets destructed
-        // and the log gets flushed.
-        throw;
-    }
+    return BotMain([&] {
+        // The Application reads the same file, named after the executable.
+        std::filesystem::path configFile{argv[0]};
+        configFile = configFile.filename().replace_extension(".json");
+        ThreadingConfig threading = ReadThreadingConfig(configFile.string());
+        bool journal = ReadStateJournalEnabled(configFile.string());
 
-    return EXIT_SUCCESS;
+        ReadyTraderGo::Application app;
+        EventRecorder events{EVENT_LOG_FILENAME};
+        if (!threading.pinned)
+        {
+            AutoTrader trader{app.GetContext()};
+            if (journal)
+            {
+                trader.JournalTo(STATE_JOURNAL_FILENAME);
+            }
+            trader.PublishMetricsTo(METRICS_FILENAME);
+            trader.RecordEventsTo(&events);
+            ReadyTraderGo::AutoTraderAppHandler appHandler{app, trader};
+            app.Run(argc, argv);
+        }
+        else
+        {
+            // The Application's thread only does I/O; the trader, its timers
+            // and everything it posts live on the trading thread.
+            boost::asio::io_context tradingContext;
+            IoBridge bridge{app.GetContext()};
+            AutoTrader trader{tradingContext};
+            trader.RelayOrdersTo(&bridge);
+            if (journal)
+            {
+                trader.JournalTo(STATE_JOURNAL_FILENAME);
+            }
+            trader.PublishMetricsTo(METRICS_FILENAME);
+            trader.RecordEventsTo(&events);
+            TradingThread tradingThread{trader, tradingContext, bridge,
+                                        threading.tradingCore};
+            ReadyTraderGo::AutoTraderAppHandler appHandler{app, bridge};
+            app.Run(argc, argv);
+        }
+    });
 }
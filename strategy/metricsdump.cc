@@ -0,0 +1,118 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+
+// Prints the metrics a running autotrader publishes, once or every few
+// seconds. Reading them never holds the autotrader up.
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "metrics.h"
+
+static void Usage(const char *name) {
+    std::cerr << "usage: " << name << " [METRICS_FILE] [--interval SECONDS]\n"
+              << "  METRICS_FILE        the autotrader's metrics (default "
+              << METRICS_FILENAME << ")\n"
+              << "  --interval SECONDS  print again every SECONDS, with the "
+                 "rate of each counter"
+              << std::endl;
+}
+
+static void Print(const MetricsReader &reader,
+                  const std::array<std::int64_t, METRIC_COUNT> &last,
+                  double seconds) {
+    for (std::size_t i = 0; i < METRIC_COUNT; i++) {
+        auto metric = static_cast<Metric>(i);
+        std::int64_t value = reader.Get(metric);
+        if (seconds > 0 && IsCounter(metric)) {
+            std::printf("%-20s %12ld %10.1f/s\n", MetricName(metric),
+                        static_cast<long>(value),
+                        static_cast<double>(value - last[i]) / seconds);
+        } else {
+            std::printf("%-20s %12ld\n", MetricName(metric),
+                        static_cast<long>(value));
+        }
+    }
+
+    if (reader.LatencyReports() == 0) {
+        std::printf("no latency report yet\n");
+    } else {
+        LatencySummaries latency = reader.Latency();
+        std::printf("%-20s %10s %10s %10s %10s %10s\n", "latency", "samples",
+                    "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+        for (std::size_t i = 0; i < latency.size(); i++) {
+            const LatencySummary &summary = latency[i];
+            std::printf("%-20s %10lu %10.0f %10.0f %10.0f %10.0f\n",
+                        LatencyProbeName(static_cast<LatencyProbe>(i)),
+                        static_cast<unsigned long>(summary.count),
+                        summary.p50, summary.p99, summary.p999, summary.max);
+        }
+    }
+    std::fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    std::string filename = METRICS_FILENAME;
+    double interval = 0.0;
+    int i = 1;
+    if (i < argc && std::string(argv[i]).rfind("--", 0) != 0) {
+        filename = argv[i++];
+    }
+    for (; i < argc; i += 2) {
+        std::string option = argv[i];
+        if (option != "--interval" || i + 1 == argc) {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        interval = std::stod(argv[i + 1]);
+    }
+
+    try {
+        MetricsReader reader(filename);
+        std::array<std::int64_t, METRIC_COUNT> last{};
+        if (interval <= 0) {
+            Print(reader, last, 0);
+            return EXIT_SUCCESS;
+        }
+
+        for (std::size_t m = 0; m < METRIC_COUNT; m++) {
+            last[m] = reader.Get(static_cast<Metric>(m));
+        }
+        auto period = std::chrono::duration<double>(interval);
+        auto next = std::chrono::steady_clock::now();
+        for (;;) {
+            next += std::chrono::duration_cast<
+                std::chrono::steady_clock::duration>(period);
+            std::this_thread::sleep_until(next);
+            Print(reader, last, interval);
+            std::printf("\n");
+            for (std::size_t m = 0; m < METRIC_COUNT; m++) {
+                last[m] = reader.Get(static_cast<Metric>(m));
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,139 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <ready_trader_go/error.h>
+#include <ready_trader_go/logging.h>
+
+#include "autotrader.h"
+#include "tradingthread.h"
+
+using namespace ReadyTraderGo;
+
+RTG_INLINE_GLOBAL_LOGGER_WITH_CHANNEL(LG_TT, "TRADING")
+
+ThreadingConfig ReadThreadingConfig(const std::string &filename) {
+    ThreadingConfig config;
+    std::ifstream file(filename);
+    if (!file) {
+        return config;
+    }
+
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(file, tree);
+    std::string mode = tree.get<std::string>("Threading.Mode", "single");
+    if (mode == "pinned") {
+        config.pinned = true;
+    } else if (mode != "single") {
+        throw ReadyTraderGoError("unknown threading mode '" + mode +
+                                 "' in " + filename);
+    }
+    config.tradingCore = tree.get<int>("Threading.TradingCore", -1);
+    return config;
+}
+
+TradingThread::TradingThread(AutoTrader &trader,
+                             boost::asio::io_context &context,
+                             IoBridge &bridge, int core)
+    : mTrader(trader), mContext(context),
+      mWork(boost::asio::make_work_guard(context)), mBridge(bridge),
+      mThread(&TradingThread::Run, this, core) {}
+
+TradingThread::~TradingThread() {
+    mStopping.store(true, std::memory_order_release);
+    mThread.join();
+}
+
+void TradingThread::Run(int core) {
+    if (core >= 0) {
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0) {
+            RLOG(LG_TT, LogLevel::LL_WARNING)
+                << "could not pin the trading thread to core " << core
+                << " (error " << error << ")";
+        }
+#else
+        RLOG(LG_TT, LogLevel::LL_WARNING)
+            << "thread pinning is not supported on this platform";
+#endif
+    }
+
+    while (!mStopping.load(std::memory_order_acquire)) {
+        if (!Dispatch()) {
+            return;
+        }
+        mContext.poll();
+    }
+    // Destroyed before the disconnect arrived: still handle what is queued.
+    Dispatch();
+    mContext.poll();
+}
+
+bool TradingThread::Dispatch() {
+    const ExchangeEvent *events;
+    std::size_t count = mBridge.Events().Peek(&events);
+    for (std::size_t i = 0; i < count; i++) {
+        const ExchangeEvent &event = events[i];
+        switch (event.type) {
+        case ExchangeEvent::DISCONNECT:
+            mBridge.Events().Release(i + 1);
+            mTrader.DisconnectHandler();
+            return false;
+        case ExchangeEvent::ERROR_MESSAGE:
+            mTrader.ErrorMessageHandler(event.id, event.error);
+            break;
+        case ExchangeEvent::HEDGE_FILLED:
+            mTrader.HedgeFilledMessageHandler(event.id, event.first,
+                                              event.second);
+            break;
+        case ExchangeEvent::ORDER_BOOK:
+            mTrader.OrderBookMessageHandler(
+                event.instrument, event.id, event.askPrices,
+                event.askVolumes, event.bidPrices, event.bidVolumes);
+            break;
+        case ExchangeEvent::ORDER_FILLED:
+            mTrader.OrderFilledMessageHandler(event.id, event.first,
+                                              event.second);
+            break;
+        case ExchangeEvent::ORDER_STATUS:
+            mTrader.OrderStatusMessageHandler(event.id, event.first,
+                                              event.second, event.fees);
+            break;
+        case ExchangeEvent::TRADE_TICKS:
+            mTrader.TradeTicksMessageHandler(
+                event.instrument, event.id, event.askPrices,
+                event.askVolumes, event.bidPrices, event.bidVolumes);
+            break;
+        }
+    }
+    mBridge.Events().Release(count);
+    return true;
+}
@@ -0,0 +1,83 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#ifndef CPPREADY_TRADER_GO_TRADINGTHREAD_H
+#define CPPREADY_TRADER_GO_TRADINGTHREAD_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+
+#include "iobridge.h"
+
+class AutoTrader;
+
+// How main runs the strategy, from the optional Threading section of the
+// autotrader's JSON configuration:
+//
+//     "Threading": {
+//       "Mode": "pinned",
+//       "TradingCore": 2
+//     }
+//
+// Mode "single" (the default) runs everything on the Application's thread.
+// Mode "pinned" runs the strategy on its own busy-polling thread, pinned to
+// TradingCore if that is given and not negative.
+struct ThreadingConfig {
+    bool pinned = false;
+    int tradingCore = -1;
+};
+
+// Defaults if the file or the section is missing; throws
+// ReadyTraderGoError for a Mode it does not know.
+ThreadingConfig ReadThreadingConfig(const std::string &filename);
+
+// Runs an AutoTrader on a thread of its own.
+//
+// The thread busy-polls the bridge's event ring, calling the matching
+// handler for each event, and in between runs whatever the trader posted to
+// its own io_context (reprices, hedges and their timers). It stops after
+// handling the disconnect, or when the TradingThread is destroyed.
+class TradingThread {
+public:
+    TradingThread(AutoTrader &trader, boost::asio::io_context &context,
+                  IoBridge &bridge, int core);
+    ~TradingThread();
+
+    TradingThread(const TradingThread &) = delete;
+    TradingThread &operator=(const TradingThread &) = delete;
+
+private:
+    void Run(int core);
+
+    // Hand the events queued so far to the trader, so that what they post
+    // runs once per batch. Returns false once it has had the disconnect.
+    bool Dispatch();
+
+    AutoTrader &mTrader;
+    boost::asio::io_context &mContext;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type>
+        mWork;
+    IoBridge &mBridge;
+    std::atomic<bool> mStopping{false};
+    std::thread mThread;
+};
+
+#endif // CPPREADY_TRADER_GO_TRADINGTHREAD_H
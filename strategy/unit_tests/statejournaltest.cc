@@ -0,0 +1,214 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+#include "statejournal.h"
+
+using namespace ReadyTraderGo;
+
+namespace {
+
+// The file layout, as statejournal.cc lays it out: a header page, whose
+// active word follows the magic, version and record size, then the two
+// regions of records.
+constexpr std::size_t HEADER_SIZE = 4096;
+constexpr std::size_t ACTIVE_OFFSET = 16;
+constexpr std::size_t RECORD_SIZE = sizeof(JournalRecord);
+
+// A journal file of its own for each test, removed before and after.
+struct JournalFile {
+    explicit JournalFile(const std::string &name) : name(name + ".dat") {
+        std::remove(this->name.c_str());
+    }
+    ~JournalFile() { std::remove(name.c_str()); }
+
+    // Overwrite raw bytes of the file, as a crash part way through a write
+    // would have left them.
+    template <typename T> void Poke(std::size_t offset, T value) const {
+        std::fstream file(name,
+                          std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    std::size_t Record(std::size_t region, std::size_t i) const {
+        return HEADER_SIZE +
+               (region * StateJournal::REGION_RECORDS + i) * RECORD_SIZE;
+    }
+
+    std::string name;
+};
+
+unsigned long BookSequence(const JournalState &state,
+                           Instrument instrument) {
+    return state.sequences[JournalState::Feed(instrument,
+                                              FeedMessage::ORDER_BOOK)];
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(state_journal)
+
+BOOST_AUTO_TEST_CASE(new_journal_is_empty) {
+    JournalFile file("new_journal_is_empty");
+    StateJournal journal(file.name);
+    BOOST_TEST(!journal.Recovered());
+    BOOST_TEST(journal.State().orderCount == 0u);
+    BOOST_TEST(journal.State().nextOrderId == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(restores_orders_hedges_and_sequences) {
+    JournalFile file("restores_orders_hedges_and_sequences");
+    {
+        StateJournal journal(file.name);
+        journal.Position(12, -10);
+        journal.Order(3, Side::SELL, 10100, 20, 0);
+        journal.Order(4, Side::BUY, 9900, 15, 5);
+        journal.Order(5, Side::BUY, 9800, 10, 0);
+        journal.Order(5, Side::BUY, 9800, 0, 10); // filled, so gone
+        journal.Hedge(6, -10);
+        journal.Hedge(7, 4);
+        journal.Hedge(6, 0); // filled, so gone
+        journal.Sequence(Instrument::FUTURE, FeedMessage::ORDER_BOOK, 41);
+        journal.Sequence(Instrument::ETF, FeedMessage::ORDER_BOOK, 40);
+        journal.Sequence(Instrument::FUTURE, FeedMessage::TRADE_TICKS, 39);
+    }
+
+    StateJournal journal(file.name);
+    const JournalState &state = journal.State();
+    BOOST_TEST(journal.Recovered());
+    BOOST_TEST(state.etfPosition == 12);
+    BOOST_TEST(state.futurePosition == -10);
+    BOOST_TEST(state.nextOrderId == 8u);
+
+    BOOST_REQUIRE(state.orderCount == 2u);
+    BOOST_TEST(state.orders[0].id == 3u);
+    BOOST_TEST((state.orders[0].side == Side::SELL));
+    BOOST_TEST(state.orders[0].price == 10100u);
+    BOOST_TEST(state.orders[0].remainingVolume == 20u);
+    BOOST_TEST(state.orders[1].id == 4u);
+    BOOST_TEST((state.orders[1].side == Side::BUY));
+    BOOST_TEST(state.orders[1].filledVolume == 5u);
+
+    BOOST_REQUIRE(state.hedgeCount == 1u);
+    BOOST_TEST(state.hedges[0].id == 7u);
+    BOOST_TEST(state.hedges[0].volume == 4);
+
+    BOOST_TEST(BookSequence(state, Instrument::FUTURE) == 41u);
+    BOOST_TEST(BookSequence(state, Instrument::ETF) == 40u);
+    BOOST_TEST(state.sequences[JournalState::Feed(
+                   Instrument::FUTURE, FeedMessage::TRADE_TICKS)] == 39u);
+}
+
+BOOST_AUTO_TEST_CASE(replay_stops_at_a_torn_record) {
+    JournalFile file("replay_stops_at_a_torn_record");
+    {
+        StateJournal journal(file.name);
+        journal.Position(1, 0);
+        journal.Position(2, 0);
+        journal.Position(3, 0);
+    }
+    // The last record's fields landed but its generation word did not.
+    file.Poke<std::uint32_t>(file.Record(0, 2), 0);
+
+    {
+        StateJournal journal(file.name);
+        BOOST_TEST(journal.State().etfPosition == 2);
+        // The next record takes the torn one's place.
+        journal.Position(4, 0);
+    }
+    StateJournal journal(file.name);
+    BOOST_TEST(journal.State().etfPosition == 4);
+}
+
+BOOST_AUTO_TEST_CASE(compacts_into_the_other_region) {
+    JournalFile file("compacts_into_the_other_region");
+    constexpr unsigned long UPDATES = 3 * StateJournal::REGION_RECORDS;
+    {
+        StateJournal journal(file.name);
+        journal.Order(9, Side::SELL, 10200, 30, 0);
+        journal.Hedge(10, 7);
+        for (unsigned long i = 1; i <= UPDATES; i++) {
+            journal.Sequence(Instrument::FUTURE, FeedMessage::ORDER_BOOK, i);
+            journal.Position(static_cast<long>(i % 100), 0);
+        }
+    }
+
+    StateJournal journal(file.name);
+    const JournalState &state = journal.State();
+    BOOST_TEST(BookSequence(state, Instrument::FUTURE) == UPDATES);
+    BOOST_TEST(state.etfPosition == static_cast<long>(UPDATES % 100));
+    BOOST_REQUIRE(state.orderCount == 1u);
+    BOOST_TEST(state.orders[0].id == 9u);
+    BOOST_REQUIRE(state.hedgeCount == 1u);
+    BOOST_TEST(state.hedges[0].volume == 7);
+    BOOST_TEST(state.nextOrderId == 11u);
+}
+
+BOOST_AUTO_TEST_CASE(crash_before_the_switch_keeps_the_old_region) {
+    JournalFile file("crash_before_the_switch_keeps_the_old_region");
+    {
+        StateJournal journal(file.name);
+        for (unsigned long i = 1; i <= StateJournal::REGION_RECORDS; i++) {
+            journal.Sequence(Instrument::ETF, FeedMessage::ORDER_BOOK, i);
+        }
+        // The first region is full: this one goes into the snapshot.
+        journal.Sequence(Instrument::ETF, FeedMessage::ORDER_BOOK, 99999);
+    }
+    // Undo the switch, as if the crash came just before it: generation one
+    // in the first region, which is still whole.
+    file.Poke<std::uint64_t>(ACTIVE_OFFSET, 2);
+
+    StateJournal journal(file.name);
+    BOOST_TEST(BookSequence(journal.State(), Instrument::ETF) ==
+               StateJournal::REGION_RECORDS);
+}
+
+BOOST_AUTO_TEST_CASE(clear_starts_afresh) {
+    JournalFile file("clear_starts_afresh");
+    {
+        StateJournal journal(file.name);
+        journal.Position(50, -50);
+        journal.Order(3, Side::BUY, 9900, 10, 0);
+        journal.Sequence(Instrument::FUTURE, FeedMessage::ORDER_BOOK, 500);
+        journal.Clear();
+        journal.Sequence(Instrument::FUTURE, FeedMessage::ORDER_BOOK, 2);
+    }
+
+    StateJournal journal(file.name);
+    const JournalState &state = journal.State();
+    BOOST_TEST(state.etfPosition == 0);
+    BOOST_TEST(state.orderCount == 0u);
+    BOOST_TEST(state.nextOrderId == 1u);
+    BOOST_TEST(BookSequence(state, Instrument::FUTURE) == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(refuses_a_file_that_is_not_a_journal) {
+    JournalFile file("refuses_a_file_that_is_not_a_journal");
+    std::ofstream(file.name) << "not a journal";
+    BOOST_CHECK_THROW(StateJournal journal(file.name), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
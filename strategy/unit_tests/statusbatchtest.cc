@@ -0,0 +1,73 @@
+// Copyright 2021 Optiver Asia Pacific Pty. Ltd.
+//
+// This file is part of Ready Trader Go.
+//
+//     Ready Trader Go is free software: you can redistribute it and/or
+//     modify it under the terms of the GNU Affero General Public License
+//     as published by the Free Software Foundation, either version 3 of
+//     the License, or (at your option) any later version.
+//
+//     Ready Trader Go is distributed in the hope that it will be useful,
+//     but WITHOUT ANY WARRANTY; without even the implied warranty of
+//     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//     GNU Affero General Public License for more details.
+//
+//     You should have received a copy of the GNU Affero General Public
+//     License along with Ready Trader Go.  If not, see
+//     <https://www.gnu.org/licenses/>.
+#include <boost/test/unit_test.hpp>
+
+#include "statusbatch.h"
+
+BOOST_AUTO_TEST_SUITE(status_batch)
+
+BOOST_AUTO_TEST_CASE(merges_statuses_for_the_same_order) {
+    StatusBatch<4> batch;
+    BOOST_TEST(batch.Empty());
+    BOOST_TEST(batch.Add(3, 5, 15));
+    BOOST_TEST(batch.Add(4, 0, 10));
+    BOOST_TEST(batch.Add(3, 8, 12));
+
+    BOOST_REQUIRE(batch.end() - batch.begin() == 2);
+    BOOST_TEST(batch.begin()[0].clientOrderId == 3u);
+    BOOST_TEST(batch.begin()[0].fillVolume == 8u);
+    BOOST_TEST(batch.begin()[0].remainingVolume == 12u);
+    BOOST_TEST(batch.begin()[1].clientOrderId == 4u);
+}
+
+BOOST_AUTO_TEST_CASE(a_stale_status_does_not_undo_a_fill) {
+    // Statuses can arrive out of order; the merged entry must not count a
+    // fill twice or reopen volume that was already filled.
+    StatusBatch<4> batch;
+    batch.Add(3, 5, 15);
+    batch.Add(3, 3, 17);
+    batch.Add(3, 5, 15);
+
+    BOOST_REQUIRE(batch.end() - batch.begin() == 1);
+    BOOST_TEST(batch.begin()->fillVolume == 5u);
+    BOOST_TEST(batch.begin()->remainingVolume == 15u);
+}
+
+BOOST_AUTO_TEST_CASE(a_closed_order_stays_closed) {
+    StatusBatch<4> batch;
+    batch.Add(3, 5, 0);  // cancelled after a partial fill
+    batch.Add(3, 5, 15); // an earlier status, delivered late
+
+    BOOST_TEST(batch.begin()->remainingVolume == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(a_full_batch_refuses_new_orders_only) {
+    StatusBatch<2> batch;
+    BOOST_TEST(batch.Add(3, 0, 10));
+    BOOST_TEST(batch.Add(4, 0, 10));
+    BOOST_TEST(batch.Full());
+    BOOST_TEST(!batch.Add(5, 0, 10));
+    BOOST_TEST(batch.Add(4, 2, 8));
+    BOOST_TEST(batch.end() - batch.begin() == 2);
+
+    batch.Clear();
+    BOOST_TEST(batch.Empty());
+    BOOST_TEST(batch.Add(5, 0, 10));
+}
+
+BOOST_AUTO_TEST_SUITE_END()